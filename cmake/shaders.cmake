@@ -1,6 +1,6 @@
 find_program(SLANGC_EXECUTABLE NAMES slangc REQUIRED)
 
-set(KT_SHADERS "${KT_SHADER_DIR}/camera.slang" "${KT_SHADER_DIR}/keptech.slang")
+set(KT_SHADERS "${KT_SHADER_DIR}/camera.slang" "${KT_SHADER_DIR}/instance.slang" "${KT_SHADER_DIR}/keptech.slang")
 
 function(_compile_slang_file)
   set(SINGLEVALUE SOURCE OUT TARGET)
@@ -37,9 +37,13 @@ endfunction()
 
 
 function(compile_shader target shader_target)
-  set(MULTIVALUE SOURCES INCLUDES)
+  set(MULTIVALUE SOURCES INCLUDES ENTRIES)
   cmake_parse_arguments(PARSE_ARGV 0 arg "" "" "${MULTIVALUE}")
 
+  if(NOT arg_ENTRIES)
+    set(arg_ENTRIES vert frag)
+  endif()
+
   set(VALID_OUTPUT_TARGETS GLSL SPIRV)
 
   if(NOT shader_target IN_LIST VALID_OUTPUT_TARGETS)
@@ -59,10 +63,10 @@ function(compile_shader target shader_target)
 
     if(${shader_target} STREQUAL SPIRV)
       set(OUT_FILE ${CMAKE_BINARY_DIR}/shaders/raw/${source}.spv)
-      _compile_slang_file(SOURCE ${SOURCE_FILE} TARGET ${shader_target} ENTRIES vert frag OUT ${OUT_FILE} INCLUDED_FILES ${INCLUDED_FILES})
+      _compile_slang_file(SOURCE ${SOURCE_FILE} TARGET ${shader_target} ENTRIES ${arg_ENTRIES} OUT ${OUT_FILE} INCLUDED_FILES ${INCLUDED_FILES})
       list(APPEND OUTPUTS ${OUT_FILE})
     else()
-      foreach(stage vert frag)
+      foreach(stage ${arg_ENTRIES})
         set(OUT_FILE ${CMAKE_BINARY_DIR}/shaders/raw/${source}_${stage}.glsl)
         _compile_slang_file(SOURCE ${SOURCE_FILE} TARGET ${shader_target} ENTRIES "${stage}" OUT ${OUT_FILE})
         list(APPEND OUTPUTS ${OUT_FILE})
@@ -82,7 +86,7 @@ function(compile_shader target shader_target)
       set(RAW_FILES ${CMAKE_BINARY_DIR}/shaders/raw/${source}.spv)
     else()
       set(RAW_FILES "")
-      foreach(stage vert frag)
+      foreach(stage ${arg_ENTRIES})
         set(RAW_FILES ${RAW_FILES} ${CMAKE_BINARY_DIR}/shaders/raw/${source}_${stage}.glsl)
       endforeach()
     endif()
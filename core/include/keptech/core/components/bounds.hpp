@@ -0,0 +1,12 @@
+#pragma once
+
+#include "keptech/core/maths/bounds.hpp"
+
+namespace keptech::components {
+  /// Local space bounds of an entity. Entities with both Bounds and a
+  /// Transform are tracked by the SpatialIndex, which reads the bounds again
+  /// whenever the transform moves.
+  struct Bounds {
+    maths::Bounds local;
+  };
+} // namespace keptech::components
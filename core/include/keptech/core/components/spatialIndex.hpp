@@ -0,0 +1,112 @@
+#pragma once
+
+#include "bounds.hpp"
+#include "keptech/core/maths/bvh.hpp"
+#include "keptech/core/maths/octree.hpp"
+#include "static.hpp"
+#include "transform.hpp"
+#include <cstdint>
+#include <keptech/ecs/ecs.hpp>
+#include <span>
+#include <vector>
+
+namespace keptech::components {
+  /// World space bounding boxes of every entity with a Transform and Bounds,
+  /// kept in a dynamic BVH so renderers and gameplay systems can find what
+  /// is in view or nearby without visiting every entity. Entities tagged
+  /// Static go in a loose octree instead, which costs nothing per frame
+  /// until the static set changes. Queries cover both.
+  ///
+  /// Bounds are updated in postUpdate for the entities the TransformSystem
+  /// moved that frame, so it must be registered after the TransformSystem.
+  /// Queries are const and safe to run from several threads outside of
+  /// postUpdate.
+  class SpatialIndex : public ecs::System {
+  public:
+    void postUpdate(const ecs::FrameData& frameData) override;
+
+    void onEntityAdded(ecs::EntityHandle entity) override;
+    void onEntityRemoved(ecs::EntityHandle entity) override;
+
+    /// Rebuilds the static octree if static entities changed since it was
+    /// built. Called from postUpdate; call it directly after adding static
+    /// entities outside the update phases to have them found straight away.
+    void updateStatic();
+
+    /// Entities at least partly inside a frustum, with how far inside each
+    /// one is.
+    struct Culled {
+      std::vector<ecs::EntityHandle> entities;
+      std::vector<maths::IntersectionType> results;
+    };
+
+    /// Finds the entities at least partly inside the frustum. The trees only
+    /// classify their nodes; entities under partly inside nodes are culled
+    /// together by their world bounds with `maths::cullBounds`.
+    [[nodiscard]] Culled cull(const maths::Frustum& frustum) const;
+
+    /// Calls `fn(entity, IntersectionType)` for every entity at least partly
+    /// inside the frustum.
+    template <typename Fn>
+    void query(const maths::Frustum& frustum, Fn&& fn) const {
+      Culled culled = cull(frustum);
+      for (size_t i = 0; i < culled.entities.size(); ++i) {
+        fn(culled.entities[i], culled.results[i]);
+      }
+    }
+
+    /// Calls `fn(entity)` for every entity whose box overlaps `box`.
+    template <typename Fn> void query(const maths::AABB& box, Fn&& fn) const {
+      tree.query(box, fn);
+      staticTree.query(box, fn);
+    }
+
+    /// Calls `fn(entity)` for every entity whose box overlaps `sphere`.
+    template <typename Fn>
+    void query(const maths::Sphere& sphere, Fn&& fn) const {
+      tree.query(sphere, fn);
+      staticTree.query(sphere, fn);
+    }
+
+    /// Calls `fn(entity, distance)` for every entity whose box the ray hits
+    /// within `maxDistance`, in no particular order.
+    template <typename Fn>
+    void raycast(const maths::Ray& ray, float maxDistance, Fn&& fn) const {
+      tree.raycast(ray, maxDistance, fn);
+      staticTree.raycast(ray, maxDistance, fn);
+    }
+
+    /// World space bounds of an entity in the index, as of the last
+    /// postUpdate.
+    [[nodiscard]] const maths::Bounds&
+    getWorldBounds(ecs::EntityHandle entity) const {
+      return worldBounds[ecs::entityIndex(entity)];
+    }
+
+    [[nodiscard]] const maths::DynamicBVH& getTree() const { return tree; }
+    [[nodiscard]] const maths::LooseOctree& getStaticTree() const {
+      return staticTree;
+    }
+
+    [[nodiscard]] static inline ecs::Signature getSignature() {
+      auto& ecs = ecs::ECS::get();
+      return ecs.signatureFromComponents<Transform, Bounds>();
+    }
+
+  private:
+    /// Recomputes `worldBounds` for the entities from their transforms, in
+    /// one batch.
+    void updateWorldBounds(std::span<const ecs::EntityHandle> changed);
+
+    /// World bounds of every entity in the index, indexed by entity index.
+    std::vector<maths::Bounds> worldBounds;
+
+    maths::DynamicBVH tree;
+    /// Proxy of each dynamic entity in `tree`, indexed by entity index.
+    std::vector<maths::DynamicBVH::Proxy> proxies;
+
+    maths::LooseOctree staticTree;
+    ecs::SparseSet staticEntities;
+    bool staticChanged = false;
+  };
+} // namespace keptech::components
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace keptech::components {
+  /// Marks an entity that is not expected to move. The SpatialIndex keeps
+  /// static entities in an octree built once rather than in its dynamic BVH,
+  /// rebuilding it only when static entities are added, removed or moved.
+  ///
+  /// Must be added before or along with Bounds, as the SpatialIndex picks a
+  /// structure when the entity first gains both Bounds and a Transform.
+  struct Static {};
+} // namespace keptech::components
@@ -2,15 +2,36 @@
 
 #include "keptech/core/maths/transform.hpp"
 #include "keptech/ecs/base.hpp"
+#include <glm/glm.hpp>
 
 namespace keptech::components {
+  /// Local transform of an entity, relative to its parent.
+  /// The global transform and world matrix are filled in by the
+  /// TransformSystem, once per frame, for transforms that changed or whose
+  /// parent did.
   struct Transform {
-    maths::Transform local;
-    maths::Transform global;
+    Transform() = default;
+    explicit Transform(const maths::Transform& localTransform)
+        : local(localTransform) {}
+
+    [[nodiscard]] const maths::Transform& getLocal() const { return local; }
 
-    void recalculateGlobalTransform();
+    /// Gets the local transform for writing, marking it dirty.
+    [[nodiscard]] maths::Transform& modifyLocal() {
+      dirty = true;
+      return local;
+    }
+
+    [[nodiscard]] const maths::Transform& getGlobal() const { return global; }
+    [[nodiscard]] const glm::mat4& getWorld() const { return world; }
 
     [[nodiscard]] bool isDirty() const { return dirty; }
+    void markDirty() { dirty = true; }
+
+    [[nodiscard]] ecs::EntityHandle getParent() const { return parent; }
+    [[nodiscard]] bool hasParent() const {
+      return parent != ecs::INVALID_ENTITY_HANDLE;
+    }
 
     void setParent(const ecs::EntityHandle newParent) {
       if (parent != newParent) {
@@ -20,7 +41,13 @@ namespace keptech::components {
     }
 
   private:
-    bool dirty = false;
+    friend class TransformSystem;
+
+    maths::Transform local;
+    maths::Transform global;
+    glm::mat4 world{1.0f};
+
+    bool dirty = true;
     ecs::EntityHandle parent = ecs::INVALID_ENTITY_HANDLE;
   };
 } // namespace keptech::components
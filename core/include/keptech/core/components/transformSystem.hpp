@@ -0,0 +1,84 @@
+#pragma once
+
+#include "keptech/core/maths/transformBatch.hpp"
+#include "transform.hpp"
+#include <cstdint>
+#include <keptech/ecs/ecs.hpp>
+#include <span>
+#include <vector>
+
+namespace keptech::components {
+  /// Propagates local transforms down the parent hierarchy once per frame.
+  ///
+  /// The hierarchy is kept as a flat array sorted by depth, so every parent
+  /// comes before its children and a single linear pass can compose each
+  /// world matrix from its already updated parent. Only dirty transforms and
+  /// the subtrees under them are recomputed.
+  ///
+  /// The array is rebuilt when transforms are added or removed, or when an
+  /// entity's parent differs from the one it was sorted under. Entities whose
+  /// parent has no Transform are treated as roots.
+  class TransformSystem : public ecs::System {
+  public:
+    void postUpdate(const ecs::FrameData& frameData) override;
+
+    void onEntityAdded(ecs::EntityHandle entity) override {
+      (void)entity;
+      hierarchyChanged = true;
+    }
+    void onEntityRemoved(ecs::EntityHandle entity) override {
+      (void)entity;
+      hierarchyChanged = true;
+    }
+
+    /// Entities whose world matrix changed in the last postUpdate, in no
+    /// particular order.
+    [[nodiscard]] std::span<const ecs::EntityHandle> getMoved() const {
+      return moved;
+    }
+
+    [[nodiscard]] static inline ecs::Signature getSignature() {
+      auto& ecs = ecs::ECS::get();
+      return ecs.signatureFromComponents<Transform>();
+    }
+
+  private:
+    constexpr static uint32_t NO_PARENT = UINT32_MAX;
+    /// Levels with fewer nodes than this are updated on the calling thread.
+    constexpr static size_t PARALLEL_THRESHOLD = 1024;
+
+    struct Node {
+      ecs::EntityHandle entity;
+      /// Parent handle the node was sorted under, to spot reparenting.
+      ecs::EntityHandle parentEntity;
+      /// Index of the parent in `nodes`, or NO_PARENT for roots.
+      uint32_t parent;
+    };
+
+    /// Per-thread buffers for batching the nodes of a range.
+    struct Scratch {
+      std::vector<uint32_t> indices;
+      maths::TransformBatch locals;
+      std::vector<glm::mat4> parents;
+      std::vector<glm::mat4> worlds;
+      std::vector<ecs::EntityHandle> moved;
+    };
+
+    void rebuild();
+
+    /// Updates nodes [begin, end), whose parents are already up to date.
+    void updateRange(size_t begin, size_t end, bool force, Scratch& scratch);
+
+    std::vector<Node> nodes;
+    /// Start of each depth in `nodes`, followed by the node count.
+    std::vector<uint32_t> levels;
+
+    /// Per-frame scratch, indexed like `nodes`.
+    std::vector<Transform*> transforms;
+    std::vector<uint8_t> changed;
+    std::vector<Scratch> threadScratch;
+    std::vector<ecs::EntityHandle> moved;
+
+    bool hierarchyChanged = true;
+  };
+} // namespace keptech::components
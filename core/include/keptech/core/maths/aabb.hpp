@@ -0,0 +1,121 @@
+#pragma once
+
+#include "intersection.hpp"
+#include "plane.hpp"
+#include <concepts>
+#include <functional>
+#include <glm/glm.hpp>
+#include <limits>
+#include <ranges>
+
+namespace keptech::maths {
+  struct AABB;
+  struct Sphere;
+
+  template <class T>
+  concept AABBIntersectable = requires(const T& obj, const AABB& box) {
+    { obj.inAABB(box) } -> std::same_as<IntersectionType>;
+  };
+
+  /// Axis aligned bounding box. Default constructed boxes are empty, with min
+  /// above max, so growing one by a point gives a box around just that point.
+  struct AABB {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    [[nodiscard]] bool isEmpty() const {
+      return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    [[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5f; }
+    /// Half the size along each axis.
+    [[nodiscard]] glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    [[nodiscard]] float surfaceArea() const {
+      glm::vec3 size = max - min;
+      return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    [[nodiscard]] bool contains(const AABB& other) const {
+      return glm::all(glm::lessThanEqual(min, other.min)) &&
+             glm::all(glm::greaterThanEqual(max, other.max));
+    }
+
+    AABB& grow(const glm::vec3& point) {
+      min = glm::min(min, point);
+      max = glm::max(max, point);
+      return *this;
+    }
+
+    AABB& grow(const AABB& other) {
+      min = glm::min(min, other.min);
+      max = glm::max(max, other.max);
+      return *this;
+    }
+
+    template <AABBIntersectable T>
+    [[nodiscard]] IntersectionType intersects(const T& obj) const {
+      return obj.inAABB(*this);
+    }
+
+    /// Tests the corners furthest along and against the plane normal. The side
+    /// the plane faces counts as inside.
+    [[nodiscard]] IntersectionType inPlane(const Plane& plane) const {
+      glm::vec3 c = center();
+      glm::vec3 e = extents();
+      float dist = plane.getSignedDistance(c);
+      float reach = glm::dot(glm::abs(plane.normal), e);
+      if (dist < -reach) {
+        return IntersectionType::eNone;
+      } else if (dist > reach) {
+        return IntersectionType::eWhole;
+      } else {
+        return IntersectionType::ePartial;
+      }
+    }
+
+    [[nodiscard]] IntersectionType inAABB(const AABB& other) const {
+      if (glm::any(glm::greaterThan(min, other.max)) ||
+          glm::any(glm::lessThan(max, other.min))) {
+        return IntersectionType::eNone;
+      } else if (glm::all(glm::greaterThanEqual(min, other.min)) &&
+                 glm::all(glm::lessThanEqual(max, other.max))) {
+        return IntersectionType::eWhole;
+      } else {
+        return IntersectionType::ePartial;
+      }
+    }
+
+    [[nodiscard]] IntersectionType inSphere(const Sphere& sphere) const;
+
+    /// Smallest box around this one after the affine transform `matrix`.
+    [[nodiscard]] AABB transformed(const glm::mat4& matrix) const {
+      if (isEmpty()) {
+        return *this;
+      }
+
+      glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center(), 1.0f));
+      glm::vec3 oldExtents = extents();
+      glm::vec3 newExtents =
+          glm::abs(glm::vec3(matrix[0])) * oldExtents.x +
+          glm::abs(glm::vec3(matrix[1])) * oldExtents.y +
+          glm::abs(glm::vec3(matrix[2])) * oldExtents.z;
+
+      return AABB{.min = newCenter - newExtents, .max = newCenter + newExtents};
+    }
+
+    template <std::ranges::input_range R, typename Proj = std::identity>
+    [[nodiscard]] static AABB enclosing(const R& points, Proj proj = {}) {
+      AABB box;
+      for (const auto& point : points) {
+        box.grow(std::invoke(proj, point));
+      }
+      return box;
+    }
+  };
+
+  static_assert(AABBIntersectable<AABB>,
+                "AABB does not satisfy AABBIntersectable concept");
+  static_assert(PlaneIntersectable<AABB>,
+                "AABB does not satisfy PlaneIntersectable concept");
+} // namespace keptech::maths
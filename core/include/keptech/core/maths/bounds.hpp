@@ -0,0 +1,43 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "sphere.hpp"
+#include <functional>
+#include <glm/glm.hpp>
+#include <ranges>
+#include <span>
+
+namespace keptech::maths {
+  /// Box and sphere around the same points, so each test can use whichever
+  /// is tighter or cheaper.
+  struct Bounds {
+    AABB box;
+    Sphere sphere{.center = glm::vec3(0.0f), .radius = 0.0f};
+
+    [[nodiscard]] bool isEmpty() const { return box.isEmpty(); }
+
+    [[nodiscard]] Bounds transformed(const glm::mat4& matrix) const {
+      return Bounds{.box = box.transformed(matrix),
+                    .sphere = sphere.transformed(matrix)};
+    }
+
+    /// Bounds of the points, keeping the smaller of the Ritter sphere and the
+    /// sphere around the box centre.
+    template <std::ranges::forward_range R, typename Proj = std::identity>
+    [[nodiscard]] static Bounds enclosing(const R& points, Proj proj = {}) {
+      Sphere boxSphere = Sphere::enclosing(points, proj);
+      Sphere ritterSphere = Sphere::ritter(points, proj);
+
+      return Bounds{
+          .box = AABB::enclosing(points, proj),
+          .sphere = ritterSphere.radius < boxSphere.radius ? ritterSphere
+                                                           : boxSphere,
+      };
+    }
+  };
+
+  /// Sets `out[i]` to `local[i]` transformed by `matrices[i]`.
+  void transformBounds(std::span<const Bounds> local,
+                       std::span<const glm::mat4> matrices,
+                       std::span<Bounds> out);
+} // namespace keptech::maths
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "frustum.hpp"
+#include "intersection.hpp"
+#include "ray.hpp"
+#include "sphere.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace keptech::maths {
+  /// Dynamic AABB tree over boxes that move, appear and disappear.
+  ///
+  /// Leaves keep the exact box they were given plus a "fat" box grown by a
+  /// margin. Internal nodes bound the fat boxes of their children, so small
+  /// moves that stay inside the fat box leave the tree untouched. Larger
+  /// moves refit the leaf's ancestors in place, which is cheap but lets the
+  /// tree get looser; `optimize` rebuilds it once it has degraded enough.
+  /// Inserts pick the cheapest sibling by surface area and keep the tree
+  /// balanced with rotations.
+  ///
+  /// Proxies are stable for the lifetime of the leaf, including across
+  /// rebuilds. Queries are const and may run from several threads at once.
+  class DynamicBVH {
+  public:
+    using Proxy = uint32_t;
+    constexpr static Proxy NULL_PROXY = UINT32_MAX;
+
+    DynamicBVH() = default;
+    explicit DynamicBVH(float fatMargin) : margin(fatMargin) {}
+
+    /// Adds a leaf for `box`, carrying `userData` back out of queries.
+    Proxy insert(const AABB& box, uint32_t userData);
+    void remove(Proxy proxy);
+    /// Updates the leaf's box. Returns true if its fat box had to change.
+    bool move(Proxy proxy, const AABB& box);
+
+    /// Rebuilds the tree if moves have made it noticeably looser than when it
+    /// was last built. Meant to be called once per frame.
+    void optimize();
+    /// Rebuilds every internal node with a median split, keeping proxies.
+    void rebuild();
+
+    [[nodiscard]] const AABB& getBox(Proxy proxy) const {
+      return nodes[proxy].tight;
+    }
+    [[nodiscard]] uint32_t getUserData(Proxy proxy) const {
+      return nodes[proxy].userData;
+    }
+    [[nodiscard]] size_t size() const { return leafCount; }
+    [[nodiscard]] bool empty() const { return leafCount == 0; }
+    /// Height of the root, where a single leaf has height zero.
+    [[nodiscard]] int32_t height() const {
+      return root == NULL_PROXY ? 0 : nodes[root].height;
+    }
+    /// Summed surface area of the internal nodes relative to the root's. The
+    /// expected number of internal nodes a random query visits.
+    [[nodiscard]] float cost() const;
+
+    /// Calls `fn(userData)` for every leaf overlapping `box`.
+    template <typename Fn> void query(const AABB& box, Fn&& fn) const {
+      traverse(
+          root,
+          [&](const AABB& nodeBox) {
+            return box.intersects(nodeBox) != IntersectionType::eNone;
+          },
+          [&](const Node& leaf) {
+            if (box.intersects(leaf.tight) != IntersectionType::eNone) {
+              fn(leaf.userData);
+            }
+          });
+    }
+
+    /// Calls `fn(userData)` for every leaf overlapping `sphere`.
+    template <typename Fn> void query(const Sphere& sphere, Fn&& fn) const {
+      traverse(
+          root,
+          [&](const AABB& nodeBox) {
+            return sphere.intersects(nodeBox) != IntersectionType::eNone;
+          },
+          [&](const Node& leaf) {
+            if (sphere.intersects(leaf.tight) != IntersectionType::eNone) {
+              fn(leaf.userData);
+            }
+          });
+    }
+
+    /// Calls `fn(userData, IntersectionType)` for every leaf at least partly
+    /// inside the frustum. Subtrees wholly inside are reported without
+    /// testing their leaves.
+    template <typename Fn> void query(const Frustum& frustum, Fn&& fn) const {
+      if (root == NULL_PROXY) {
+        return;
+      }
+
+      std::vector<Proxy> stack;
+      stack.reserve(static_cast<size_t>(nodes[root].height) + 1);
+      stack.push_back(root);
+      while (!stack.empty()) {
+        Proxy index = stack.back();
+        const Node& node = nodes[index];
+        stack.pop_back();
+
+        IntersectionType result =
+            frustum.intersects(node.isLeaf() ? node.tight : node.box);
+        if (result == IntersectionType::eNone) {
+          continue;
+        } else if (node.isLeaf()) {
+          fn(node.userData, result);
+        } else if (result == IntersectionType::eWhole) {
+          traverse(
+              index, [](const AABB&) { return true; },
+              [&](const Node& leaf) {
+                fn(leaf.userData, IntersectionType::eWhole);
+              });
+        } else {
+          stack.push_back(node.child1);
+          stack.push_back(node.child2);
+        }
+      }
+    }
+
+    /// Like the frustum `query`, but leaves under partly inside nodes are
+    /// passed to `fn` as ePartial without testing them, for the caller to
+    /// classify in one batch.
+    template <typename Fn>
+    void queryNodes(const Frustum& frustum, Fn&& fn) const {
+      if (root == NULL_PROXY) {
+        return;
+      }
+
+      std::vector<Proxy> stack;
+      stack.reserve(static_cast<size_t>(nodes[root].height) + 1);
+      stack.push_back(root);
+      while (!stack.empty()) {
+        Proxy index = stack.back();
+        const Node& node = nodes[index];
+        stack.pop_back();
+
+        if (node.isLeaf()) {
+          fn(node.userData, IntersectionType::ePartial);
+          continue;
+        }
+
+        IntersectionType result = frustum.intersects(node.box);
+        if (result == IntersectionType::eNone) {
+          continue;
+        } else if (result == IntersectionType::eWhole) {
+          traverse(
+              index, [](const AABB&) { return true; },
+              [&](const Node& leaf) {
+                fn(leaf.userData, IntersectionType::eWhole);
+              });
+        } else {
+          stack.push_back(node.child1);
+          stack.push_back(node.child2);
+        }
+      }
+    }
+
+    /// Calls `fn(userData, distance)` for every leaf the ray hits within
+    /// `maxDistance`, in no particular order.
+    template <typename Fn>
+    void raycast(const Ray& ray, float maxDistance, Fn&& fn) const {
+      traverse(
+          root,
+          [&](const AABB& nodeBox) {
+            return ray.hit(nodeBox, maxDistance).has_value();
+          },
+          [&](const Node& leaf) {
+            if (auto distance = ray.hit(leaf.tight, maxDistance)) {
+              fn(leaf.userData, *distance);
+            }
+          });
+    }
+
+  private:
+    /// Rebuild once the tree costs this much more than when it was built.
+    constexpr static float REBUILD_RATIO = 1.5f;
+
+    struct Node {
+      /// Fat box for leaves, union of the children for internal nodes.
+      AABB box;
+      /// Exact box of a leaf.
+      AABB tight;
+      /// Parent, or next free node while on the free list.
+      Proxy parent = NULL_PROXY;
+      Proxy child1 = NULL_PROXY;
+      Proxy child2 = NULL_PROXY;
+      /// Zero for leaves, -1 for free nodes.
+      int32_t height = -1;
+      uint32_t userData = 0;
+
+      [[nodiscard]] bool isLeaf() const { return child1 == NULL_PROXY; }
+    };
+
+    /// Depth first walk from `from`, descending into nodes whose box `enter`
+    /// accepts and passing every leaf reached to `visit`.
+    template <typename Enter, typename Visit>
+    void traverse(Proxy from, Enter&& enter, Visit&& visit) const {
+      if (from == NULL_PROXY) {
+        return;
+      }
+
+      std::vector<Proxy> stack;
+      stack.reserve(static_cast<size_t>(nodes[from].height) + 1);
+      stack.push_back(from);
+      while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!enter(node.box)) {
+          continue;
+        } else if (node.isLeaf()) {
+          visit(node);
+        } else {
+          stack.push_back(node.child1);
+          stack.push_back(node.child2);
+        }
+      }
+    }
+
+    Proxy allocate();
+    void release(Proxy proxy);
+
+    void insertLeaf(Proxy leaf);
+    void removeLeaf(Proxy leaf);
+    /// Recomputes boxes and heights from `index` up to the root, rotating
+    /// unbalanced nodes on the way.
+    void fixUpwards(Proxy index);
+    Proxy balance(Proxy index);
+    Proxy build(std::span<Proxy> leaves);
+
+    std::vector<Node> nodes;
+    Proxy root = NULL_PROXY;
+    Proxy freeList = NULL_PROXY;
+    size_t leafCount = 0;
+
+    float margin = 0.1f;
+    /// Cost right after the last rebuild, and refits since the last check.
+    float builtCost = 0.0f;
+    size_t refits = 0;
+  };
+} // namespace keptech::maths
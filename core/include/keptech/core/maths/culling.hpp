@@ -0,0 +1,96 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "bounds.hpp"
+#include "frustum.hpp"
+#include "intersection.hpp"
+#include "sphere.hpp"
+#include <span>
+#include <vector>
+
+namespace keptech::maths {
+  /// Spheres stored as structure of arrays, for `cullSpheres`.
+  struct SphereBatch {
+    std::vector<float> x, y, z;
+    std::vector<float> radius;
+
+    [[nodiscard]] size_t size() const { return x.size(); }
+
+    void push(const Sphere& sphere) {
+      x.push_back(sphere.center.x);
+      y.push_back(sphere.center.y);
+      z.push_back(sphere.center.z);
+      radius.push_back(sphere.radius);
+    }
+
+    void reserve(size_t count) {
+      x.reserve(count);
+      y.reserve(count);
+      z.reserve(count);
+      radius.reserve(count);
+    }
+
+    void clear() {
+      x.clear();
+      y.clear();
+      z.clear();
+      radius.clear();
+    }
+  };
+
+  /// Boxes stored as structure of arrays of centres and extents, for
+  /// `cullBoxes`.
+  struct AABBBatch {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    [[nodiscard]] size_t size() const { return centerX.size(); }
+
+    void push(const AABB& box) {
+      glm::vec3 center = box.center();
+      glm::vec3 extents = box.extents();
+      centerX.push_back(center.x);
+      centerY.push_back(center.y);
+      centerZ.push_back(center.z);
+      extentX.push_back(extents.x);
+      extentY.push_back(extents.y);
+      extentZ.push_back(extents.z);
+    }
+
+    void reserve(size_t count) {
+      centerX.reserve(count);
+      centerY.reserve(count);
+      centerZ.reserve(count);
+      extentX.reserve(count);
+      extentY.reserve(count);
+      extentZ.reserve(count);
+    }
+
+    void clear() {
+      centerX.clear();
+      centerY.clear();
+      centerZ.clear();
+      extentX.clear();
+      extentY.clear();
+      extentZ.clear();
+    }
+  };
+
+  /// Classifies every sphere in the batch against the frustum, as
+  /// `Frustum::intersects` would. `out` must hold at least `spheres.size()`
+  /// results.
+  void cullSpheres(const Frustum& frustum, const SphereBatch& spheres,
+                   std::span<IntersectionType> out);
+
+  /// Classifies every box in the batch against the frustum, as
+  /// `Frustum::intersects` would. `out` must hold at least `boxes.size()`
+  /// results.
+  void cullBoxes(const Frustum& frustum, const AABBBatch& boxes,
+                 std::span<IntersectionType> out);
+
+  /// Culls by the bounding spheres, then tests the boxes of anything the
+  /// spheres left partially inside. Catches long thin objects whose spheres
+  /// reach into the frustum when their boxes do not.
+  void cullBounds(const Frustum& frustum, std::span<const Bounds> bounds,
+                  std::span<IntersectionType> out);
+} // namespace keptech::maths
@@ -22,8 +22,9 @@ namespace keptech::maths {
       return finalResult;
     }
 
-    constexpr static Frustum
-    fromViewProjectionMatrix(const glm::mat4& vpMatrix) {
+    /// Extracts the planes of a view projection matrix with a zero to one
+    /// depth range, normals facing inwards and normalized.
+    static Frustum fromViewProjectionMatrix(const glm::mat4& vpMatrix) {
       Frustum frustum = {};
 
       // Left plane
@@ -50,16 +51,20 @@ namespace keptech::maths {
                                            vpMatrix[2][3] - vpMatrix[2][1]);
       frustum.planes[3].distance = vpMatrix[3][3] - vpMatrix[3][1];
 
-      // Near plane
-      frustum.planes[4].normal = glm::vec3(vpMatrix[0][3] + vpMatrix[0][2],
-                                           vpMatrix[1][3] + vpMatrix[1][2],
-                                           vpMatrix[2][3] + vpMatrix[2][2]);
-      frustum.planes[4].distance = vpMatrix[3][3] + vpMatrix[3][2];
+      // Near plane, at z = 0 rather than z = -w
+      frustum.planes[4].normal =
+          glm::vec3(vpMatrix[0][2], vpMatrix[1][2], vpMatrix[2][2]);
+      frustum.planes[4].distance = vpMatrix[3][2];
 
       // Far plane
       frustum.planes[5].normal = glm::vec3(vpMatrix[0][3] - vpMatrix[0][2],
                                            vpMatrix[1][3] - vpMatrix[1][2],
                                            vpMatrix[2][3] - vpMatrix[2][2]);
+      frustum.planes[5].distance = vpMatrix[3][3] - vpMatrix[3][2];
+
+      for (auto& plane : frustum.planes) {
+        plane = plane.normalized();
+      }
 
       return frustum;
     }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace keptech::maths {
   enum class IntersectionType : uint8_t { eNone, ePartial, eWhole };
 }
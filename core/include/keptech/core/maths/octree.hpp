@@ -0,0 +1,160 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "frustum.hpp"
+#include "intersection.hpp"
+#include "ray.hpp"
+#include "sphere.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace keptech::maths {
+  /// Loose octree built once over boxes that do not move.
+  ///
+  /// Each cell's children may hold boxes reaching up to half a child's size
+  /// past the child's bounds, so boxes sit in the deepest cell their size
+  /// allows rather than straddling splits near the root. Items are stored
+  /// depth first, making every subtree one contiguous run. When a cell is
+  /// wholly inside a query, that run is reported without testing anything
+  /// below it.
+  ///
+  /// Cells are culled by the bounds of what they actually contain, not their
+  /// loose extents. Queries are const and may run from several threads at
+  /// once.
+  class LooseOctree {
+  public:
+    struct Item {
+      AABB box;
+      uint32_t userData;
+    };
+
+    /// Replaces the contents with `items`.
+    void build(std::span<const Item> items);
+    void clear();
+
+    [[nodiscard]] size_t size() const { return userData.size(); }
+    [[nodiscard]] bool empty() const { return userData.empty(); }
+
+    /// Calls `fn(userData, IntersectionType)` for every item at least partly
+    /// inside the frustum.
+    template <typename Fn> void query(const Frustum& frustum, Fn&& fn) const {
+      traverse(
+          [&](const AABB& box) { return frustum.intersects(box); },
+          [&](uint32_t item, IntersectionType result) {
+            fn(userData[item], result);
+          });
+    }
+
+    /// Like the frustum `query`, but items of partly inside cells are passed
+    /// to `fn` as ePartial without testing them, for the caller to classify
+    /// in one batch.
+    template <typename Fn>
+    void queryNodes(const Frustum& frustum, Fn&& fn) const {
+      traverse([&](const AABB& box) { return frustum.intersects(box); },
+               [](const AABB&) { return IntersectionType::ePartial; },
+               [&](uint32_t item, IntersectionType result) {
+                 fn(userData[item], result);
+               });
+    }
+
+    /// Calls `fn(userData)` for every item overlapping `box`.
+    template <typename Fn> void query(const AABB& box, Fn&& fn) const {
+      traverse([&](const AABB& other) { return box.intersects(other); },
+               [&](uint32_t item, IntersectionType) { fn(userData[item]); });
+    }
+
+    /// Calls `fn(userData)` for every item overlapping `sphere`.
+    template <typename Fn> void query(const Sphere& sphere, Fn&& fn) const {
+      traverse([&](const AABB& box) { return sphere.intersects(box); },
+               [&](uint32_t item, IntersectionType) { fn(userData[item]); });
+    }
+
+    /// Calls `fn(userData, distance)` for every item the ray hits within
+    /// `maxDistance`, in no particular order.
+    template <typename Fn>
+    void raycast(const Ray& ray, float maxDistance, Fn&& fn) const {
+      traverse(
+          [&](const AABB& box) {
+            return ray.hit(box, maxDistance) ? IntersectionType::ePartial
+                                             : IntersectionType::eNone;
+          },
+          [&](uint32_t item, IntersectionType) {
+            fn(userData[item], *ray.hit(boxes[item], maxDistance));
+          });
+    }
+
+  private:
+    /// Cells stop splitting past this depth, or below this many items.
+    constexpr static uint32_t MAX_DEPTH = 10;
+    constexpr static size_t LEAF_ITEMS = 16;
+
+    struct Node {
+      /// Bounds of every item in the subtree.
+      AABB bounds;
+      /// Children are stored next to each other.
+      uint32_t firstChild = 0;
+      uint32_t childCount = 0;
+      /// The cell's own items are [itemBegin, itemEnd), its subtree's
+      /// [itemBegin, subtreeEnd).
+      uint32_t itemBegin = 0;
+      uint32_t itemEnd = 0;
+      uint32_t subtreeEnd = 0;
+    };
+
+    /// Walks the cells `classify` does not reject. Items of cells it reports
+    /// as eWhole are passed to `visit` untested, the rest only if `classify`
+    /// accepts their own box.
+    template <typename Classify, typename Visit>
+    void traverse(Classify&& classify, Visit&& visit) const {
+      traverse(classify, classify, visit);
+    }
+
+    /// As above, classifying cells with `classifyCell` and the items of
+    /// partly covered cells with `classifyItem`.
+    template <typename ClassifyCell, typename ClassifyItem, typename Visit>
+    void traverse(ClassifyCell&& classifyCell, ClassifyItem&& classifyItem,
+                  Visit&& visit) const {
+      if (nodes.empty()) {
+        return;
+      }
+
+      std::vector<uint32_t> stack;
+      stack.reserve(MAX_DEPTH * 8);
+      stack.push_back(0);
+      while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        IntersectionType result = classifyCell(node.bounds);
+        if (result == IntersectionType::eNone) {
+          continue;
+        } else if (result == IntersectionType::eWhole) {
+          for (uint32_t item = node.itemBegin; item < node.subtreeEnd;
+               ++item) {
+            visit(item, IntersectionType::eWhole);
+          }
+          continue;
+        }
+
+        for (uint32_t item = node.itemBegin; item < node.itemEnd; ++item) {
+          IntersectionType itemResult = classifyItem(boxes[item]);
+          if (itemResult != IntersectionType::eNone) {
+            visit(item, itemResult);
+          }
+        }
+        for (uint32_t child = 0; child < node.childCount; ++child) {
+          stack.push_back(node.firstChild + child);
+        }
+      }
+    }
+
+    void buildNode(uint32_t index, std::span<Item> items,
+                   const glm::vec3& center, float halfSize, uint32_t depth);
+
+    std::vector<Node> nodes;
+    /// Items in depth first order, split into parallel arrays.
+    std::vector<AABB> boxes;
+    std::vector<uint32_t> userData;
+  };
+} // namespace keptech::maths
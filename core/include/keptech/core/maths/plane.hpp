@@ -1,17 +1,20 @@
 #pragma once
 
 #include "intersection.hpp"
+#include <concepts>
+#include <glm/glm.hpp>
 
 namespace keptech::maths {
   struct Plane;
 
+  /// Types that can be classified against the side a plane faces, through
+  /// `obj.inPlane(plane)`.
   template <class T>
-  concept PlaneIntersectable =
-      requires(const T& obj, float dist, const Plane& plane) {
-        { obj.inPlane(dist) } -> std::same_as<IntersectionType>;
-        { obj.intersects(plane) } -> std::same_as<IntersectionType>;
-      };
+  concept PlaneIntersectable = requires(const T& obj, const Plane& plane) {
+    { obj.inPlane(plane) } -> std::same_as<IntersectionType>;
+  };
 
+  /// Points on the side the normal faces have a positive signed distance.
   struct Plane {
     glm::vec3 normal;
     float distance;
@@ -20,6 +23,14 @@ namespace keptech::maths {
       return glm::dot(normal, point) + distance;
     }
 
+    /// Scales the plane to a unit normal, so signed distances are in world
+    /// units.
+    [[nodiscard]] Plane normalized() const {
+      float length = glm::length(normal);
+      return Plane{.normal = normal / length, .distance = distance / length};
+    }
+
+    /// Classifies `obj` against the side the plane faces.
     template <PlaneIntersectable T>
     [[nodiscard]] IntersectionType intersects(const T& obj) const {
       return obj.inPlane(*this);
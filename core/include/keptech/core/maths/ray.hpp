@@ -0,0 +1,49 @@
+#pragma once
+
+#include "aabb.hpp"
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <optional>
+#include <utility>
+
+namespace keptech::maths {
+  struct Ray {
+    glm::vec3 origin;
+    /// Need not be normalized; distances are in multiples of its length.
+    glm::vec3 direction;
+
+    [[nodiscard]] glm::vec3 at(float distance) const {
+      return origin + direction * distance;
+    }
+
+    /// Distance along the ray where it enters the box, or zero if it starts
+    /// inside. Empty if it misses or only reaches the box past `maxDistance`.
+    [[nodiscard]] std::optional<float> hit(const AABB& box,
+                                           float maxDistance) const {
+      float enter = 0.0f;
+      float exit = maxDistance;
+      for (glm::length_t axis = 0; axis < 3; ++axis) {
+        if (direction[axis] == 0.0f) {
+          if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis]) {
+            return std::nullopt;
+          }
+          continue;
+        }
+
+        float inverse = 1.0f / direction[axis];
+        float toMin = (box.min[axis] - origin[axis]) * inverse;
+        float toMax = (box.max[axis] - origin[axis]) * inverse;
+        if (toMin > toMax) {
+          std::swap(toMin, toMax);
+        }
+
+        enter = std::max(enter, toMin);
+        exit = std::min(exit, toMax);
+        if (enter > exit) {
+          return std::nullopt;
+        }
+      }
+      return enter;
+    }
+  };
+} // namespace keptech::maths
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "aabb.hpp"
 #include "intersection.hpp"
 #include "plane.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <glm/glm.hpp>
+#include <ranges>
 
 namespace keptech::maths {
   struct Sphere;
@@ -20,28 +26,114 @@ namespace keptech::maths {
       return obj.inSphere(*this);
     }
 
+    /// Classifies the sphere from the signed distance of its centre to a
+    /// plane. The side the plane faces counts as inside.
     [[nodiscard]] IntersectionType inPlane(float dist) const {
-      if (dist > radius) {
+      if (dist < -radius) {
         return IntersectionType::eNone;
-      } else if (dist < -radius) {
+      } else if (dist > radius) {
         return IntersectionType::eWhole;
       } else {
         return IntersectionType::ePartial;
       }
     }
 
-    [[nodiscard]] IntersectionType intersects(const Plane& plane) const {
-      float dist = plane.getSignedDistance(center);
-      return inPlane(dist);
+    [[nodiscard]] IntersectionType inPlane(const Plane& plane) const {
+      return inPlane(plane.getSignedDistance(center));
+    }
+
+    [[nodiscard]] IntersectionType inAABB(const AABB& box) const {
+      glm::vec3 closest = glm::clamp(center, box.min, box.max);
+      glm::vec3 to = closest - center;
+      if (glm::dot(to, to) > radius * radius) {
+        return IntersectionType::eNone;
+      } else if (glm::all(glm::greaterThanEqual(center - radius, box.min)) &&
+                 glm::all(glm::lessThanEqual(center + radius, box.max))) {
+        return IntersectionType::eWhole;
+      } else {
+        return IntersectionType::ePartial;
+      }
+    }
+
+    /// Bounds of the sphere after the affine transform `matrix`. Non-uniform
+    /// scale is covered by the largest axis.
+    [[nodiscard]] Sphere transformed(const glm::mat4& matrix) const {
+      glm::vec4 moved = matrix * glm::vec4(center, 1.0f);
+      float scale = std::max({glm::length(glm::vec3(matrix[0])),
+                              glm::length(glm::vec3(matrix[1])),
+                              glm::length(glm::vec3(matrix[2]))});
+      return Sphere{.center = glm::vec3(moved), .radius = radius * scale};
+    }
+
+    /// Sphere around the centre of the points' bounding box. Looser than the
+    /// smallest enclosing sphere, but a single pass over the points.
+    template <std::ranges::forward_range R, typename Proj = std::identity>
+    [[nodiscard]] static Sphere enclosing(const R& points, Proj proj = {}) {
+      AABB box = AABB::enclosing(points, proj);
+      if (box.isEmpty()) {
+        return Sphere{.center = glm::vec3(0.0f), .radius = 0.0f};
+      }
+
+      glm::vec3 center = box.center();
+      float radiusSq = 0.0f;
+      for (const auto& point : points) {
+        glm::vec3 to = std::invoke(proj, point) - center;
+        radiusSq = std::max(radiusSq, glm::dot(to, to));
+      }
+
+      return Sphere{.center = center, .radius = std::sqrt(radiusSq)};
+    }
+
+    /// Ritter's bounding sphere: starts from two far apart points and grows to
+    /// take in any point left outside. Usually within a few percent of the
+    /// smallest enclosing sphere.
+    template <std::ranges::forward_range R, typename Proj = std::identity>
+    [[nodiscard]] static Sphere ritter(const R& points, Proj proj = {}) {
+      if (std::ranges::empty(points)) {
+        return Sphere{.center = glm::vec3(0.0f), .radius = 0.0f};
+      }
+
+      auto farthestFrom = [&](const glm::vec3& from) {
+        glm::vec3 farthest = from;
+        float farthestSq = 0.0f;
+        for (const auto& point : points) {
+          glm::vec3 position = std::invoke(proj, point);
+          glm::vec3 to = position - from;
+          if (glm::dot(to, to) > farthestSq) {
+            farthestSq = glm::dot(to, to);
+            farthest = position;
+          }
+        }
+        return farthest;
+      };
+
+      glm::vec3 first = std::invoke(proj, *std::ranges::begin(points));
+      glm::vec3 a = farthestFrom(first);
+      glm::vec3 b = farthestFrom(a);
+
+      Sphere sphere{.center = (a + b) * 0.5f,
+                    .radius = glm::length(b - a) * 0.5f};
+      for (const auto& point : points) {
+        glm::vec3 to = std::invoke(proj, point) - sphere.center;
+        float dist = glm::length(to);
+        if (dist > sphere.radius) {
+          float newRadius = (sphere.radius + dist) * 0.5f;
+          sphere.center += to * ((dist - newRadius) / dist);
+          sphere.radius = newRadius;
+        }
+      }
+
+      return sphere;
     }
 
     [[nodiscard]] IntersectionType inSphere(const Sphere& other) const {
       glm::vec3 to = other.center - center;
       float distSq = glm::dot(to, to);
       float radiusSum = radius + other.radius;
+      float slack = other.radius - radius;
       if (distSq > radiusSum * radiusSum) {
         return IntersectionType::eNone;
-      } else if (distSq < (radius - other.radius) * (radius - other.radius)) {
+      } else if (slack >= 0.0f && distSq <= slack * slack) {
         return IntersectionType::eWhole;
       } else {
         return IntersectionType::ePartial;
@@ -53,4 +145,8 @@ namespace keptech::maths {
                 "Sphere does not satisfy SphereIntersectable concept");
   static_assert(PlaneIntersectable<Sphere>,
                 "Sphere does not satisfy PlaneIntersectable concept");
+  static_assert(AABBIntersectable<Sphere>,
+                "Sphere does not satisfy AABBIntersectable concept");
+  static_assert(SphereIntersectable<AABB>,
+                "AABB does not satisfy SphereIntersectable concept");
 } // namespace keptech::maths
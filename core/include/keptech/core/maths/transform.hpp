@@ -41,18 +41,23 @@ namespace keptech::maths {
       return *this;
     }
 
+    /// Composes `other` as the parent of this transform.
     Transform& apply(const Transform& other) {
-      position += other.position;
+      position = other.position + other.rotation * (other._scale * position);
       rotation = other.rotation * rotation;
       _scale *= other._scale;
       return *this;
     }
 
+    /// Translation * rotation * scale, built directly rather than by
+    /// multiplying three matrices.
     [[nodiscard]] glm::mat4 toMatrix() const {
-      glm::mat4 translationMat = glm::translate(glm::mat4(1.0f), position);
-      glm::mat4 rotationMat = glm::mat4(rotation);
-      glm::mat4 scaleMat = glm::scale(glm::mat4(1.0f), _scale);
-      return translationMat * rotationMat * scaleMat;
+      glm::mat4 matrix = glm::mat4_cast(rotation);
+      matrix[0] *= _scale.x;
+      matrix[1] *= _scale.y;
+      matrix[2] *= _scale.z;
+      matrix[3] = glm::vec4(position, 1.0f);
+      return matrix;
     }
 
     explicit operator glm::mat4() const { return toMatrix(); }
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "transform.hpp"
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace keptech::maths {
+  /// Affine matrix stored as three rows, with the translation in the last
+  /// column. The implied fourth row is (0, 0, 0, 1).
+  struct Matrix3x4 {
+    std::array<glm::vec4, 3> rows;
+
+    [[nodiscard]] glm::mat4 toMat4() const {
+      glm::mat4 matrix(1.0f);
+      for (glm::length_t row = 0; row < 3; ++row) {
+        for (glm::length_t column = 0; column < 4; ++column) {
+          matrix[column][row] = rows[static_cast<size_t>(row)][column];
+        }
+      }
+      return matrix;
+    }
+  };
+
+  /// Transforms stored as structure of arrays, one array per component, so
+  /// the batch kernels can load several transforms per instruction.
+  struct TransformBatch {
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> rotX, rotY, rotZ, rotW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    [[nodiscard]] size_t size() const { return posX.size(); }
+
+    void push(const Transform& transform) {
+      posX.push_back(transform.pos().x);
+      posY.push_back(transform.pos().y);
+      posZ.push_back(transform.pos().z);
+      rotX.push_back(transform.rot().x);
+      rotY.push_back(transform.rot().y);
+      rotZ.push_back(transform.rot().z);
+      rotW.push_back(transform.rot().w);
+      scaleX.push_back(transform.scale().x);
+      scaleY.push_back(transform.scale().y);
+      scaleZ.push_back(transform.scale().z);
+    }
+
+    void reserve(size_t count) {
+      for (auto* lane : lanes()) {
+        lane->reserve(count);
+      }
+    }
+
+    void clear() {
+      for (auto* lane : lanes()) {
+        lane->clear();
+      }
+    }
+
+  private:
+    std::array<std::vector<float>*, 10> lanes() {
+      return {&posX, &posY, &posZ, &rotX,   &rotY,
+              &rotZ, &rotW, &scaleX, &scaleY, &scaleZ};
+    }
+  };
+
+  /// Converts every transform in the batch to a translation * rotation *
+  /// scale matrix. `out` must hold at least `batch.size()` matrices.
+  void toMatrices(const TransformBatch& batch, std::span<glm::mat4> out);
+
+  /// As `toMatrices`, writing the compact 3x4 form.
+  void toMatrices(const TransformBatch& batch, std::span<Matrix3x4> out);
+
+  /// Sets `out[i] = parents[i] * locals[i]`. `out` may alias `locals` or
+  /// `parents`.
+  void multiplyMatrices(std::span<const glm::mat4> parents,
+                        std::span<const glm::mat4> locals,
+                        std::span<glm::mat4> out);
+} // namespace keptech::maths
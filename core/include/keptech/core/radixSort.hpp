@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace keptech::core {
+  /// Stable LSD radix sort of `items` by the 64 bit key `key` projects from
+  /// each item.
+  ///
+  /// Keys are sorted alongside item indices a byte at a time, and the items
+  /// are moved into place once at the end, so large items cost a single
+  /// move each. Bytes every key shares are skipped, so keys only using a few
+  /// of their bits sort in a few passes.
+  template <typename T, typename Proj>
+  void radixSort(std::vector<T>& items, Proj key) {
+    if (items.size() < 2) {
+      return;
+    }
+
+    struct Entry {
+      uint64_t key;
+      uint32_t index;
+    };
+
+    constexpr size_t RADIX = 256;
+    constexpr size_t PASSES = sizeof(uint64_t);
+
+    std::vector<Entry> entries(items.size());
+    std::array<std::array<size_t, RADIX>, PASSES> counts{};
+    for (size_t i = 0; i < items.size(); ++i) {
+      uint64_t itemKey = std::invoke(key, items[i]);
+      entries[i] = {.key = itemKey, .index = static_cast<uint32_t>(i)};
+      for (size_t pass = 0; pass < PASSES; ++pass) {
+        ++counts[pass][(itemKey >> (pass * 8)) & (RADIX - 1)];
+      }
+    }
+
+    std::vector<Entry> scratch(entries.size());
+    for (size_t pass = 0; pass < PASSES; ++pass) {
+      auto& count = counts[pass];
+      uint64_t sharedByte = (entries.front().key >> (pass * 8)) & (RADIX - 1);
+      if (count[sharedByte] == entries.size()) {
+        continue;
+      }
+
+      size_t offset = 0;
+      for (auto& bucket : count) {
+        size_t bucketSize = bucket;
+        bucket = offset;
+        offset += bucketSize;
+      }
+
+      for (const auto& entry : entries) {
+        scratch[count[(entry.key >> (pass * 8)) & (RADIX - 1)]++] = entry;
+      }
+      entries.swap(scratch);
+    }
+
+    std::vector<T> sorted;
+    sorted.reserve(items.size());
+    for (const auto& entry : entries) {
+      sorted.push_back(std::move(items[entry.index]));
+    }
+    items = std::move(sorted);
+  }
+} // namespace keptech::core
@@ -3,11 +3,18 @@
 #include "keptech/core/window.hpp"
 #include "keptech/ecs/system.hpp"
 #include <concepts>
+#include <filesystem>
 
 namespace keptech::core::renderer {
 
   struct CreateInfo {
     const char* applicationName = "Keptech App";
+    /// Cull and build draws on the GPU, recording one indirect draw per
+    /// material and mesh instead of one instanced draw per visible group.
+    bool gpuDriven = false;
+    /// File compiled pipelines are kept in between runs. Left empty,
+    /// pipelines are compiled from scratch every run.
+    std::filesystem::path pipelineCachePath = {};
   };
 
   class Renderer : public ecs::System {};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "keptech/core/maths/bounds.hpp"
 #include "keptech/core/slotmap.hpp"
+#include <span>
 
 namespace keptech::core::rendering {
   struct Mesh {
@@ -40,16 +42,33 @@ namespace keptech::core::rendering {
     struct Submesh {
       uint32_t indexCount;
       uint32_t indexOffset;
+      /// Bounds of the vertices the submesh draws, in mesh space.
+      keptech::maths::Bounds bounds{};
     };
 
     std::string name;
     std::vector<Submesh> submeshes;
+    /// Bounds of every vertex, in mesh space.
+    keptech::maths::Bounds bounds{};
   };
 
+  /// Fills in the bounds of each submesh and returns the bounds of the whole
+  /// mesh. Submeshes index into `indices`, or straight into `vertices` when
+  /// there are no indices.
+  keptech::maths::Bounds computeBounds(std::span<const Mesh::Vertex> vertices,
+                                       std::span<const uint32_t> indices,
+                                       std::span<Mesh::Submesh> submeshes);
+
   struct MeshData {
     std::string name;
     std::vector<rendering::Mesh::Vertex> vertices;
     std::vector<uint32_t> indices = {};
     std::vector<rendering::Mesh::Submesh> submeshes = {};
+    /// Empty until `computeBounds` is called.
+    keptech::maths::Bounds bounds = {};
+
+    void computeBounds() {
+      bounds = rendering::computeBounds(vertices, indices, submeshes);
+    }
   };
 } // namespace keptech::core::rendering
@@ -399,7 +399,9 @@ namespace keptech::core {
 
     SlotMapSmartHandle(SlotMapHandle handle, std::function<void()> deleter)
         : handle(handle), refCount(new SlotMapRefs()),
-          deleter(std::move(deleter)) {}
+          deleter(std::move(deleter)) {
+      refCount->newStrongRef();
+    }
 
     SlotMapSmartHandle(SlotMapHandle handle, SlotMapRefs& refCount,
                        std::function<void()> deleter)
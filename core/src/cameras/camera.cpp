@@ -15,9 +15,7 @@ namespace keptech::core::cameras {
             ecs.getComponent<components::Transform>(attachedEntity);
 
         if (transform) {
-          transform->recalculateGlobalTransform();
-
-          auto copy = transform->global;
+          auto copy = transform->getGlobal();
           copy.translate(position);
           copy.rotate(rotation);
 
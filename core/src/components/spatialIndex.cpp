@@ -0,0 +1,159 @@
+#include "keptech/core/components/spatialIndex.hpp"
+
+#include "keptech/core/components/transformSystem.hpp"
+#include "keptech/core/maths/culling.hpp"
+#include <cassert>
+
+namespace keptech::components {
+  void SpatialIndex::postUpdate(const ecs::FrameData& frameData) {
+    (void)frameData;
+
+    auto& ecs = ecs::ECS::get();
+    auto& transforms = ecs.getSystem<TransformSystem>();
+
+    std::vector<ecs::EntityHandle> moved;
+    for (ecs::EntityHandle entity : transforms.getMoved()) {
+      if (staticEntities.contains(entity)) {
+        staticChanged = true;
+        continue;
+      }
+
+      ecs::EntityIndex index = ecs::entityIndex(entity);
+      if (index < proxies.size() &&
+          proxies[index] != maths::DynamicBVH::NULL_PROXY) {
+        moved.push_back(entity);
+      }
+    }
+
+    updateWorldBounds(moved);
+    for (ecs::EntityHandle entity : moved) {
+      ecs::EntityIndex index = ecs::entityIndex(entity);
+      tree.move(proxies[index], worldBounds[index].box);
+    }
+
+    tree.optimize();
+    updateStatic();
+  }
+
+  void SpatialIndex::onEntityAdded(ecs::EntityHandle entity) {
+    auto& ecs = ecs::ECS::get();
+    if (ecs.hasComponent<Static>(entity)) {
+      staticEntities.insert(entity);
+      staticChanged = true;
+      return;
+    }
+
+    ecs::EntityIndex index = ecs::entityIndex(entity);
+    if (index >= proxies.size()) {
+      proxies.resize(index + 1, maths::DynamicBVH::NULL_PROXY);
+    }
+
+    assert(proxies[index] == maths::DynamicBVH::NULL_PROXY &&
+           "Entity is already in the spatial index.");
+    updateWorldBounds({&entity, 1});
+    proxies[index] = tree.insert(worldBounds[index].box, entity);
+  }
+
+  void SpatialIndex::onEntityRemoved(ecs::EntityHandle entity) {
+    if (staticEntities.contains(entity)) {
+      staticEntities.erase(entity);
+      staticChanged = true;
+      return;
+    }
+
+    ecs::EntityIndex index = ecs::entityIndex(entity);
+    if (index >= proxies.size() ||
+        proxies[index] == maths::DynamicBVH::NULL_PROXY) {
+      return;
+    }
+
+    tree.remove(proxies[index]);
+    proxies[index] = maths::DynamicBVH::NULL_PROXY;
+  }
+
+  void SpatialIndex::updateStatic() {
+    if (!staticChanged) {
+      return;
+    }
+
+    std::vector<ecs::EntityHandle> statics(staticEntities.begin(),
+                                           staticEntities.end());
+    updateWorldBounds(statics);
+
+    std::vector<maths::LooseOctree::Item> items;
+    items.reserve(statics.size());
+    for (ecs::EntityHandle entity : statics) {
+      items.push_back({.box = worldBounds[ecs::entityIndex(entity)].box,
+                       .userData = entity});
+    }
+
+    staticTree.build(items);
+    staticChanged = false;
+  }
+
+  SpatialIndex::Culled
+  SpatialIndex::cull(const maths::Frustum& frustum) const {
+    Culled culled;
+    std::vector<ecs::EntityHandle> candidates;
+    auto sort = [&](ecs::EntityHandle entity, maths::IntersectionType result) {
+      if (result == maths::IntersectionType::eWhole) {
+        culled.entities.push_back(entity);
+        culled.results.push_back(result);
+      } else {
+        candidates.push_back(entity);
+      }
+    };
+    tree.queryNodes(frustum, sort);
+    staticTree.queryNodes(frustum, sort);
+
+    std::vector<maths::Bounds> bounds;
+    bounds.reserve(candidates.size());
+    for (ecs::EntityHandle entity : candidates) {
+      bounds.push_back(worldBounds[ecs::entityIndex(entity)]);
+    }
+
+    std::vector<maths::IntersectionType> results(candidates.size());
+    maths::cullBounds(frustum, bounds, results);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (results[i] != maths::IntersectionType::eNone) {
+        culled.entities.push_back(candidates[i]);
+        culled.results.push_back(results[i]);
+      }
+    }
+    return culled;
+  }
+
+  void SpatialIndex::updateWorldBounds(
+      std::span<const ecs::EntityHandle> changed) {
+    auto& ecs = ecs::ECS::get();
+
+    std::vector<maths::Bounds> local;
+    std::vector<glm::mat4> matrices;
+    local.reserve(changed.size());
+    matrices.reserve(changed.size());
+    for (ecs::EntityHandle entity : changed) {
+      local.push_back(ecs.getComponentRef<Bounds>(entity).local);
+      matrices.push_back(ecs.getComponentRef<Transform>(entity).getWorld());
+    }
+
+    std::vector<maths::Bounds> world(changed.size());
+    maths::transformBounds(local, matrices, world);
+
+    for (size_t i = 0; i < changed.size(); ++i) {
+      // Entities without any extent are tracked as a point at their origin.
+      if (local[i].isEmpty()) {
+        glm::vec3 origin = glm::vec3(matrices[i][3]);
+        world[i] = maths::Bounds{
+            .box = maths::AABB{.min = origin, .max = origin},
+            .sphere = maths::Sphere{.center = origin, .radius = 0.0f},
+        };
+      }
+
+      ecs::EntityIndex index = ecs::entityIndex(changed[i]);
+      if (index >= worldBounds.size()) {
+        worldBounds.resize(index + 1);
+      }
+      worldBounds[index] = world[i];
+    }
+  }
+} // namespace keptech::components
@@ -0,0 +1,198 @@
+#include "keptech/core/components/transformSystem.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace keptech::components {
+  void TransformSystem::postUpdate(const ecs::FrameData& frameData) {
+    (void)frameData;
+
+    auto& ecs = ecs::ECS::get();
+
+    bool force = hierarchyChanged;
+    if (hierarchyChanged) {
+      rebuild();
+    }
+
+    // Returns false if any entity was reparented since the last rebuild.
+    auto gather = [&]() {
+      transforms.resize(nodes.size());
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        transforms[i] = &ecs.getComponentRef<Transform>(nodes[i].entity);
+        if (transforms[i]->parent != nodes[i].parentEntity) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    if (!gather()) {
+      rebuild();
+      gather();
+      force = true;
+    }
+
+    changed.assign(nodes.size(), 0);
+
+    auto& pool = ecs.getThreadPool();
+    threadScratch.resize(pool.getConcurrency());
+    for (auto& scratch : threadScratch) {
+      scratch.moved.clear();
+    }
+
+    for (size_t level = 0; level + 1 < levels.size(); ++level) {
+      size_t begin = levels[level];
+      size_t end = levels[level + 1];
+
+      if (end - begin < PARALLEL_THRESHOLD || pool.getWorkerCount() == 0) {
+        updateRange(begin, end, force, threadScratch[pool.threadIndex()]);
+        continue;
+      }
+
+      // Nodes in a level only read their parents, which are all in earlier
+      // levels, so a level can be split freely.
+      ecs::JobGroup group;
+      for (size_t start = begin; start < end; start += PARALLEL_THRESHOLD) {
+        size_t stop = std::min(start + PARALLEL_THRESHOLD, end);
+        pool.submit(
+            [this, &pool, start, stop, force]() {
+              updateRange(start, stop, force,
+                          threadScratch[pool.threadIndex()]);
+            },
+            group);
+      }
+      pool.wait(group);
+    }
+
+    moved.clear();
+    for (const auto& scratch : threadScratch) {
+      moved.insert(moved.end(), scratch.moved.begin(), scratch.moved.end());
+    }
+  }
+
+  void TransformSystem::updateRange(size_t begin, size_t end, bool force,
+                                    Scratch& scratch) {
+    scratch.indices.clear();
+    scratch.locals.clear();
+    scratch.parents.clear();
+
+    for (size_t i = begin; i < end; ++i) {
+      const Node& node = nodes[i];
+      const Transform& transform = *transforms[i];
+
+      bool parentChanged = node.parent != NO_PARENT && changed[node.parent];
+      if (!force && !transform.dirty && !parentChanged) {
+        continue;
+      }
+
+      scratch.indices.push_back(static_cast<uint32_t>(i));
+      scratch.locals.push(transform.local);
+      scratch.parents.push_back(node.parent == NO_PARENT
+                                    ? glm::mat4(1.0f)
+                                    : transforms[node.parent]->world);
+    }
+
+    if (scratch.indices.empty()) {
+      return;
+    }
+
+    scratch.worlds.resize(scratch.indices.size());
+    maths::toMatrices(scratch.locals, scratch.worlds);
+    maths::multiplyMatrices(scratch.parents, scratch.worlds, scratch.worlds);
+
+    for (size_t k = 0; k < scratch.indices.size(); ++k) {
+      uint32_t i = scratch.indices[k];
+      const Node& node = nodes[i];
+      Transform& transform = *transforms[i];
+
+      transform.world = scratch.worlds[k];
+      transform.global = transform.local;
+      if (node.parent != NO_PARENT) {
+        transform.global.apply(transforms[node.parent]->global);
+      }
+
+      transform.dirty = false;
+      changed[i] = 1;
+      scratch.moved.push_back(node.entity);
+    }
+  }
+
+  void TransformSystem::rebuild() {
+    constexpr uint32_t UNVISITED = UINT32_MAX;
+    constexpr uint32_t VISITING = UINT32_MAX - 1;
+
+    auto& ecs = ecs::ECS::get();
+    size_t count = entities.size();
+
+    std::vector<ecs::EntityHandle> parentEntities(count);
+    std::vector<uint32_t> parents(count);
+    for (size_t i = 0; i < count; ++i) {
+      auto& transform = ecs.getComponentRef<Transform>(entities[i]);
+      parentEntities[i] = transform.parent;
+
+      // A parent without a Transform is not in the set, leaving a root.
+      uint32_t parent = transform.hasParent()
+                            ? entities.indexOf(transform.parent)
+                            : ecs::SparseSet::INVALID_INDEX;
+      parents[i] = parent == ecs::SparseSet::INVALID_INDEX ? NO_PARENT : parent;
+    }
+
+    // Walk up from each node until reaching a root or a node with a known
+    // depth, then assign depths on the way back down.
+    std::vector<uint32_t> depths(count, UNVISITED);
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+    for (size_t i = 0; i < count; ++i) {
+      auto current = static_cast<uint32_t>(i);
+      while (current != NO_PARENT && depths[current] == UNVISITED) {
+        depths[current] = VISITING;
+        chain.push_back(current);
+        current = parents[current];
+      }
+
+      uint32_t depth = 0;
+      if (current != NO_PARENT) {
+        if (depths[current] == VISITING) [[unlikely]] {
+          assert(false && "Transform hierarchy contains a cycle.");
+          // Break the cycle by promoting the topmost node to a root.
+          parents[chain.back()] = NO_PARENT;
+        } else {
+          depth = depths[current] + 1;
+        }
+      }
+
+      while (!chain.empty()) {
+        depths[chain.back()] = depth;
+        maxDepth = std::max(maxDepth, depth);
+        ++depth;
+        chain.pop_back();
+      }
+    }
+
+    // Counting sort by depth, so parents always precede their children.
+    levels.assign(count == 0 ? 1 : maxDepth + 2, 0);
+    for (size_t i = 0; i < count; ++i) {
+      ++levels[depths[i] + 1];
+    }
+    for (size_t level = 1; level < levels.size(); ++level) {
+      levels[level] += levels[level - 1];
+    }
+
+    std::vector<uint32_t> positions(count);
+    std::vector<uint32_t> next(levels.begin(), levels.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+      positions[i] = next[depths[i]]++;
+    }
+
+    nodes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      nodes[positions[i]] = Node{
+          .entity = entities[i],
+          .parentEntity = parentEntities[i],
+          .parent = parents[i] == NO_PARENT ? NO_PARENT : positions[parents[i]],
+      };
+    }
+
+    hierarchyChanged = false;
+  }
+} // namespace keptech::components
@@ -21,7 +21,9 @@ namespace keptech::core::gltf {
           };
           submeshes.push_back(submesh);
 
-          size_t startIndex = indices.size();
+          // Each primitive's vertices follow the previous ones, so its
+          // indices are offset to match.
+          size_t startVertex = vertices.size();
 
           // Indices
           {
@@ -31,7 +33,9 @@ namespace keptech::core::gltf {
 
             fastgltf::iterateAccessor<uint32_t>(
                 asset, indicesAccessor,
-                [&](uint32_t index) { indices.push_back(index); });
+                [&](uint32_t index) {
+                  indices.push_back(static_cast<uint32_t>(startVertex + index));
+                });
           }
 
           // Positions
@@ -39,15 +43,14 @@ namespace keptech::core::gltf {
             auto& posAccessor =
                 asset.accessors[primitive.findAttribute("POSITION")
                                     ->accessorIndex];
-            vertices.resize(std::max(vertices.size(),
-                                     static_cast<size_t>(posAccessor.count)));
+            vertices.resize(startVertex + posAccessor.count);
 
             fastgltf::iterateAccessorWithIndex<glm::vec3>(
                 asset, posAccessor, [&](glm::vec3 position, size_t index) {
                   rendering::Mesh::Vertex vertex{};
                   vertex.position = position;
                   vertex.position.y *= -1;
-                  vertices[startIndex + index] = vertex;
+                  vertices[startVertex + index] = vertex;
                 });
           }
 
@@ -60,7 +63,7 @@ namespace keptech::core::gltf {
               fastgltf::iterateAccessorWithIndex<glm::vec3>(
                   asset, normalAccessor, [&](glm::vec3 normal, size_t index) {
                     normal.y *= -1;
-                    vertices[startIndex + index].normal = normal;
+                    vertices[startVertex + index].normal = normal;
                   });
             }
           }
@@ -73,8 +76,8 @@ namespace keptech::core::gltf {
 
               fastgltf::iterateAccessorWithIndex<glm::vec2>(
                   asset, uvAccessor, [&](glm::vec2 uv, size_t index) {
-                    vertices[startIndex + index].uvX = uv.x;
-                    vertices[startIndex + index].uvY = uv.y * -1;
+                    vertices[startVertex + index].uvX = uv.x;
+                    vertices[startVertex + index].uvY = uv.y * -1;
                   });
             }
           }
@@ -87,7 +90,7 @@ namespace keptech::core::gltf {
 
               fastgltf::iterateAccessorWithIndex<glm::vec4>(
                   asset, colorAccessor, [&](glm::vec4 color, size_t index) {
-                    vertices[startIndex + index].color = color;
+                    vertices[startVertex + index].color = color;
                   });
             }
           }
@@ -101,7 +104,7 @@ namespace keptech::core::gltf {
               fastgltf::iterateAccessorWithIndex<glm::vec4>(
                   asset, tangentAccessor, [&](glm::vec4 tangent, size_t index) {
                     tangent.y *= -1;
-                    vertices[startIndex + index].tangent = tangent;
+                    vertices[startVertex + index].tangent = tangent;
                   });
             }
           }
@@ -113,6 +116,7 @@ namespace keptech::core::gltf {
             .indices = std::move(indices),
             .submeshes = std::move(submeshes),
         };
+        meshData.computeBounds();
         std::shared_ptr meshPtr =
             std::make_shared<rendering::MeshData>(std::move(meshData));
 
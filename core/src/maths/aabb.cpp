@@ -0,0 +1,22 @@
+#include "keptech/core/maths/aabb.hpp"
+
+#include "keptech/core/maths/sphere.hpp"
+
+namespace keptech::maths {
+  IntersectionType AABB::inSphere(const Sphere& sphere) const {
+    glm::vec3 closest = glm::clamp(sphere.center, min, max);
+    glm::vec3 toClosest = closest - sphere.center;
+    float radiusSq = sphere.radius * sphere.radius;
+    if (glm::dot(toClosest, toClosest) > radiusSq) {
+      return IntersectionType::eNone;
+    }
+
+    // The corner furthest from the centre decides whether all of it is inside.
+    glm::vec3 toFarthest = glm::max(glm::abs(min - sphere.center),
+                                    glm::abs(max - sphere.center));
+    if (glm::dot(toFarthest, toFarthest) <= radiusSq) {
+      return IntersectionType::eWhole;
+    }
+    return IntersectionType::ePartial;
+  }
+} // namespace keptech::maths
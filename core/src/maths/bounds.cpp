@@ -0,0 +1,16 @@
+#include "keptech/core/maths/bounds.hpp"
+
+#include <cassert>
+
+namespace keptech::maths {
+  void transformBounds(std::span<const Bounds> local,
+                       std::span<const glm::mat4> matrices,
+                       std::span<Bounds> out) {
+    assert(local.size() == matrices.size() && out.size() >= local.size() &&
+           "Mismatched bounds spans.");
+
+    for (size_t i = 0; i < local.size(); ++i) {
+      out[i] = local[i].transformed(matrices[i]);
+    }
+  }
+} // namespace keptech::maths
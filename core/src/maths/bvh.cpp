@@ -0,0 +1,332 @@
+#include "keptech/core/maths/bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace keptech::maths {
+  namespace {
+    AABB merged(const AABB& a, const AABB& b) {
+      AABB box = a;
+      return box.grow(b);
+    }
+  } // namespace
+
+  DynamicBVH::Proxy DynamicBVH::insert(const AABB& box, uint32_t userData) {
+    Proxy proxy = allocate();
+    Node& node = nodes[proxy];
+    node.tight = box;
+    node.box = AABB{.min = box.min - margin, .max = box.max + margin};
+    node.height = 0;
+    node.userData = userData;
+
+    insertLeaf(proxy);
+    ++leafCount;
+    return proxy;
+  }
+
+  void DynamicBVH::remove(Proxy proxy) {
+    assert(proxy < nodes.size() && nodes[proxy].height == 0 &&
+           "Proxy is not a leaf.");
+
+    removeLeaf(proxy);
+    release(proxy);
+    --leafCount;
+  }
+
+  bool DynamicBVH::move(Proxy proxy, const AABB& box) {
+    assert(proxy < nodes.size() && nodes[proxy].height == 0 &&
+           "Proxy is not a leaf.");
+
+    Node& node = nodes[proxy];
+    node.tight = box;
+    if (node.box.contains(box)) {
+      return false;
+    }
+
+    node.box = AABB{.min = box.min - margin, .max = box.max + margin};
+    for (Proxy index = node.parent; index != NULL_PROXY;
+         index = nodes[index].parent) {
+      Node& parent = nodes[index];
+      parent.box = merged(nodes[parent.child1].box, nodes[parent.child2].box);
+    }
+    ++refits;
+    return true;
+  }
+
+  void DynamicBVH::optimize() {
+    // Measuring the cost walks every node, so only check once a fair share of
+    // the leaves have been refit.
+    if (refits <= leafCount / 8) {
+      return;
+    }
+    refits = 0;
+
+    if (cost() > builtCost * REBUILD_RATIO) {
+      rebuild();
+    }
+  }
+
+  void DynamicBVH::rebuild() {
+    std::vector<Proxy> leaves;
+    leaves.reserve(leafCount);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (nodes[i].height == 0) {
+        leaves.push_back(static_cast<Proxy>(i));
+      } else if (nodes[i].height > 0) {
+        release(static_cast<Proxy>(i));
+      }
+    }
+
+    root = build(leaves);
+    if (root != NULL_PROXY) {
+      nodes[root].parent = NULL_PROXY;
+    }
+
+    builtCost = cost();
+    refits = 0;
+  }
+
+  float DynamicBVH::cost() const {
+    if (root == NULL_PROXY) {
+      return 0.0f;
+    }
+
+    float rootArea = nodes[root].box.surfaceArea();
+    if (rootArea <= 0.0f) {
+      return 0.0f;
+    }
+
+    float area = 0.0f;
+    for (const auto& node : nodes) {
+      if (node.height > 0) {
+        area += node.box.surfaceArea();
+      }
+    }
+    return area / rootArea;
+  }
+
+  DynamicBVH::Proxy DynamicBVH::allocate() {
+    if (freeList == NULL_PROXY) {
+      nodes.emplace_back();
+      return static_cast<Proxy>(nodes.size() - 1);
+    }
+
+    Proxy proxy = freeList;
+    freeList = nodes[proxy].parent;
+    nodes[proxy] = Node{};
+    return proxy;
+  }
+
+  void DynamicBVH::release(Proxy proxy) {
+    nodes[proxy] = Node{};
+    nodes[proxy].parent = freeList;
+    freeList = proxy;
+  }
+
+  void DynamicBVH::insertLeaf(Proxy leaf) {
+    if (root == NULL_PROXY) {
+      root = leaf;
+      nodes[root].parent = NULL_PROXY;
+      return;
+    }
+
+    // Walk down towards the sibling that adds the least surface area, counting
+    // the growth of every ancestor along the way.
+    AABB leafBox = nodes[leaf].box;
+    Proxy index = root;
+    while (!nodes[index].isLeaf()) {
+      const Node& node = nodes[index];
+      float area = node.box.surfaceArea();
+      float combinedArea = merged(node.box, leafBox).surfaceArea();
+
+      // Cost of pairing with this node, and the growth every node below it
+      // inherits.
+      float here = 2.0f * combinedArea;
+      float inherited = 2.0f * (combinedArea - area);
+
+      auto descendCost = [&](Proxy child) {
+        const Node& childNode = nodes[child];
+        float childCost =
+            merged(childNode.box, leafBox).surfaceArea() + inherited;
+        if (!childNode.isLeaf()) {
+          childCost -= childNode.box.surfaceArea();
+        }
+        return childCost;
+      };
+
+      float cost1 = descendCost(node.child1);
+      float cost2 = descendCost(node.child2);
+      if (here < cost1 && here < cost2) {
+        break;
+      }
+      index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    Proxy sibling = index;
+    Proxy oldParent = nodes[sibling].parent;
+    Proxy newParent = allocate();
+
+    Node& parent = nodes[newParent];
+    parent.parent = oldParent;
+    parent.box = merged(leafBox, nodes[sibling].box);
+    parent.height = nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_PROXY) {
+      root = newParent;
+    } else if (nodes[oldParent].child1 == sibling) {
+      nodes[oldParent].child1 = newParent;
+    } else {
+      nodes[oldParent].child2 = newParent;
+    }
+
+    fixUpwards(newParent);
+  }
+
+  void DynamicBVH::removeLeaf(Proxy leaf) {
+    if (leaf == root) {
+      root = NULL_PROXY;
+      return;
+    }
+
+    Proxy parent = nodes[leaf].parent;
+    Proxy grandParent = nodes[parent].parent;
+    Proxy sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                                 : nodes[parent].child1;
+
+    nodes[sibling].parent = grandParent;
+    release(parent);
+
+    if (grandParent == NULL_PROXY) {
+      root = sibling;
+      return;
+    }
+
+    if (nodes[grandParent].child1 == parent) {
+      nodes[grandParent].child1 = sibling;
+    } else {
+      nodes[grandParent].child2 = sibling;
+    }
+    fixUpwards(grandParent);
+  }
+
+  void DynamicBVH::fixUpwards(Proxy index) {
+    while (index != NULL_PROXY) {
+      index = balance(index);
+
+      Node& node = nodes[index];
+      const Node& child1 = nodes[node.child1];
+      const Node& child2 = nodes[node.child2];
+      node.height = 1 + std::max(child1.height, child2.height);
+      node.box = merged(child1.box, child2.box);
+
+      index = node.parent;
+    }
+  }
+
+  DynamicBVH::Proxy DynamicBVH::balance(Proxy aIndex) {
+    Node& a = nodes[aIndex];
+    if (a.isLeaf() || a.height < 2) {
+      return aIndex;
+    }
+
+    Proxy bIndex = a.child1;
+    Proxy cIndex = a.child2;
+    Node& b = nodes[bIndex];
+    Node& c = nodes[cIndex];
+
+    // Rotates `up`, the taller child of A, into A's place. A keeps its other
+    // child and takes the shorter of up's children, up keeps the taller one.
+    auto rotate = [&](Proxy upIndex, Node& up, Node& kept, bool upWasChild1) {
+      Proxy fIndex = up.child1;
+      Proxy gIndex = up.child2;
+      Node& f = nodes[fIndex];
+      Node& g = nodes[gIndex];
+
+      up.child1 = aIndex;
+      up.parent = a.parent;
+      a.parent = upIndex;
+
+      if (up.parent == NULL_PROXY) {
+        root = upIndex;
+      } else if (nodes[up.parent].child1 == aIndex) {
+        nodes[up.parent].child1 = upIndex;
+      } else {
+        nodes[up.parent].child2 = upIndex;
+      }
+
+      bool keepF = f.height > g.height;
+      Proxy tallIndex = keepF ? fIndex : gIndex;
+      Proxy shortIndex = keepF ? gIndex : fIndex;
+      Node& tall = nodes[tallIndex];
+      Node& shortChild = nodes[shortIndex];
+
+      up.child2 = tallIndex;
+      if (upWasChild1) {
+        a.child1 = shortIndex;
+      } else {
+        a.child2 = shortIndex;
+      }
+      shortChild.parent = aIndex;
+
+      a.box = merged(kept.box, shortChild.box);
+      up.box = merged(a.box, tall.box);
+      a.height = 1 + std::max(kept.height, shortChild.height);
+      up.height = 1 + std::max(a.height, tall.height);
+      return upIndex;
+    };
+
+    int32_t difference = c.height - b.height;
+    if (difference > 1) {
+      return rotate(cIndex, c, b, false);
+    } else if (difference < -1) {
+      return rotate(bIndex, b, c, true);
+    }
+    return aIndex;
+  }
+
+  DynamicBVH::Proxy DynamicBVH::build(std::span<Proxy> leaves) {
+    if (leaves.empty()) {
+      return NULL_PROXY;
+    } else if (leaves.size() == 1) {
+      return leaves.front();
+    }
+
+    // Split at the median centre along the widest axis of the centres.
+    AABB centers;
+    for (Proxy leaf : leaves) {
+      centers.grow(nodes[leaf].box.center());
+    }
+    glm::vec3 spread = centers.max - centers.min;
+    glm::length_t axis = spread.x > spread.y ? 0 : 1;
+    if (spread.z > spread[axis]) {
+      axis = 2;
+    }
+
+    size_t middle = leaves.size() / 2;
+    std::ranges::nth_element(leaves,
+                             leaves.begin() +
+                                 static_cast<std::ptrdiff_t>(middle),
+                             [&](Proxy lhs, Proxy rhs) {
+                               return nodes[lhs].box.center()[axis] <
+                                      nodes[rhs].box.center()[axis];
+                             });
+
+    Proxy child1 = build(leaves.first(middle));
+    Proxy child2 = build(leaves.subspan(middle));
+    Proxy proxy = allocate();
+
+    Node& node = nodes[proxy];
+    node.child1 = child1;
+    node.child2 = child2;
+    node.box = merged(nodes[child1].box, nodes[child2].box);
+    node.height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+    nodes[child1].parent = proxy;
+    nodes[child2].parent = proxy;
+    return proxy;
+  }
+} // namespace keptech::maths
@@ -0,0 +1,153 @@
+#include "keptech/core/maths/culling.hpp"
+
+#include "simd.hpp"
+#include <cassert>
+
+namespace keptech::maths {
+  namespace {
+    Sphere sphereAt(const SphereBatch& spheres, size_t i) {
+      return Sphere{
+          .center = glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]),
+          .radius = spheres.radius[i],
+      };
+    }
+
+#ifdef KT_MATHS_SIMD
+    /// Signed distances of the points to the plane, summed in the same order
+    /// as `Plane::getSignedDistance` so both give bit identical results.
+    simd::V signedDistance(const Plane& plane, simd::V x, simd::V y,
+                           simd::V z) {
+      return simd::add(
+          simd::add(simd::add(simd::mul(simd::set(plane.normal.x), x),
+                              simd::mul(simd::set(plane.normal.y), y)),
+                    simd::mul(simd::set(plane.normal.z), z)),
+          simd::set(plane.distance));
+    }
+
+    void storeResults(simd::V outside, simd::V partial,
+                      std::span<IntersectionType> out) {
+      unsigned outsideMask = simd::mask(outside);
+      unsigned partialMask = simd::mask(partial);
+      for (size_t lane = 0; lane < simd::WIDTH; ++lane) {
+        unsigned bit = 1u << lane;
+        out[lane] = (outsideMask & bit)   ? IntersectionType::eNone
+                    : (partialMask & bit) ? IntersectionType::ePartial
+                                          : IntersectionType::eWhole;
+      }
+    }
+#endif
+  } // namespace
+
+  void cullSpheres(const Frustum& frustum, const SphereBatch& spheres,
+                   std::span<IntersectionType> out) {
+    assert(out.size() >= spheres.size() && "Output span is too small.");
+
+    size_t i = 0;
+#ifdef KT_MATHS_SIMD
+    for (; i + simd::WIDTH <= spheres.size(); i += simd::WIDTH) {
+      simd::V x = simd::load(&spheres.x[i]);
+      simd::V y = simd::load(&spheres.y[i]);
+      simd::V z = simd::load(&spheres.z[i]);
+      simd::V radius = simd::load(&spheres.radius[i]);
+      simd::V negRadius = simd::sub(simd::set(0.0f), radius);
+
+      // Lanes behind any plane are outside. Lanes not fully in front of every
+      // plane are partially inside.
+      simd::V outside = simd::set(0.0f);
+      simd::V partial = simd::set(0.0f);
+      for (const auto& plane : frustum.planes) {
+        simd::V dist = signedDistance(plane, x, y, z);
+
+        outside = simd::bitOr(outside, simd::less(dist, negRadius));
+        partial = simd::bitOr(partial, simd::lessEqual(dist, radius));
+      }
+
+      storeResults(outside, partial, out.subspan(i, simd::WIDTH));
+
+#ifndef NDEBUG
+      for (size_t lane = i; lane < i + simd::WIDTH; ++lane) {
+        assert(out[lane] == frustum.intersects(sphereAt(spheres, lane)) &&
+               "SIMD sphere cull disagrees with Frustum::intersects.");
+      }
+#endif
+    }
+#endif
+
+    for (; i < spheres.size(); ++i) {
+      out[i] = frustum.intersects(sphereAt(spheres, i));
+    }
+  }
+
+  void cullBoxes(const Frustum& frustum, const AABBBatch& boxes,
+                 std::span<IntersectionType> out) {
+    assert(out.size() >= boxes.size() && "Output span is too small.");
+
+    size_t i = 0;
+#ifdef KT_MATHS_SIMD
+    for (; i + simd::WIDTH <= boxes.size(); i += simd::WIDTH) {
+      simd::V x = simd::load(&boxes.centerX[i]);
+      simd::V y = simd::load(&boxes.centerY[i]);
+      simd::V z = simd::load(&boxes.centerZ[i]);
+      simd::V ex = simd::load(&boxes.extentX[i]);
+      simd::V ey = simd::load(&boxes.extentY[i]);
+      simd::V ez = simd::load(&boxes.extentZ[i]);
+
+      // As with spheres, but each box reaches as far from the plane as its
+      // extents projected onto the normal.
+      simd::V outside = simd::set(0.0f);
+      simd::V partial = simd::set(0.0f);
+      for (const auto& plane : frustum.planes) {
+        glm::vec3 absNormal = glm::abs(plane.normal);
+        simd::V dist = signedDistance(plane, x, y, z);
+        simd::V reach =
+            simd::add(simd::add(simd::mul(simd::set(absNormal.x), ex),
+                                simd::mul(simd::set(absNormal.y), ey)),
+                      simd::mul(simd::set(absNormal.z), ez));
+
+        outside = simd::bitOr(
+            outside, simd::less(dist, simd::sub(simd::set(0.0f), reach)));
+        partial = simd::bitOr(partial, simd::lessEqual(dist, reach));
+      }
+
+      storeResults(outside, partial, out.subspan(i, simd::WIDTH));
+    }
+#endif
+
+    for (; i < boxes.size(); ++i) {
+      glm::vec3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+      glm::vec3 extents(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+      AABB box{.min = center - extents, .max = center + extents};
+      out[i] = frustum.intersects(box);
+    }
+  }
+
+  void cullBounds(const Frustum& frustum, std::span<const Bounds> bounds,
+                  std::span<IntersectionType> out) {
+    assert(out.size() >= bounds.size() && "Output span is too small.");
+
+    SphereBatch spheres;
+    spheres.reserve(bounds.size());
+    for (const auto& each : bounds) {
+      spheres.push(each.sphere);
+    }
+    cullSpheres(frustum, spheres, out);
+
+    std::vector<size_t> partial;
+    AABBBatch boxes;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+      if (out[i] == IntersectionType::ePartial && !bounds[i].box.isEmpty()) {
+        partial.push_back(i);
+        boxes.push(bounds[i].box);
+      }
+    }
+    if (partial.empty()) {
+      return;
+    }
+
+    std::vector<IntersectionType> refined(partial.size());
+    cullBoxes(frustum, boxes, refined);
+    for (size_t i = 0; i < partial.size(); ++i) {
+      out[partial[i]] = refined[i];
+    }
+  }
+} // namespace keptech::maths
@@ -0,0 +1,110 @@
+#include "keptech/core/maths/octree.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace keptech::maths {
+  void LooseOctree::build(std::span<const Item> items) {
+    clear();
+    if (items.empty()) {
+      return;
+    }
+
+    AABB all;
+    for (const auto& item : items) {
+      all.grow(item.box);
+    }
+    glm::vec3 extents = all.extents();
+    float halfSize = std::max({extents.x, extents.y, extents.z});
+
+    std::vector<Item> sorted(items.begin(), items.end());
+    boxes.reserve(sorted.size());
+    userData.reserve(sorted.size());
+    nodes.emplace_back();
+    buildNode(0, sorted, all.center(), halfSize, 0);
+  }
+
+  void LooseOctree::clear() {
+    nodes.clear();
+    boxes.clear();
+    userData.clear();
+  }
+
+  void LooseOctree::buildNode(uint32_t index, std::span<Item> items,
+                              const glm::vec3& center, float halfSize,
+                              uint32_t depth) {
+    // A child's loose bounds reach half its size past the cell, so anything
+    // up to that size fits whichever child holds its centre.
+    float childHalfSize = halfSize * 0.5f;
+    bool split = depth < MAX_DEPTH && items.size() > LEAF_ITEMS;
+    auto stays = [&](const Item& item) {
+      glm::vec3 extents = item.box.extents();
+      return !split ||
+             std::max({extents.x, extents.y, extents.z}) > childHalfSize;
+    };
+    auto moving = std::ranges::partition(items, stays);
+    auto staying = items.first(items.size() - moving.size());
+
+    AABB bounds;
+    nodes[index].itemBegin = static_cast<uint32_t>(boxes.size());
+    for (const auto& item : staying) {
+      boxes.push_back(item.box);
+      userData.push_back(item.userData);
+      bounds.grow(item.box);
+    }
+    nodes[index].itemEnd = static_cast<uint32_t>(boxes.size());
+
+    auto octant = [&](const Item& item) {
+      glm::vec3 itemCenter = item.box.center();
+      return (itemCenter.x >= center.x ? 1u : 0u) |
+             (itemCenter.y >= center.y ? 2u : 0u) |
+             (itemCenter.z >= center.z ? 4u : 0u);
+    };
+
+    std::array<size_t, 9> starts{};
+    for (const auto& item : moving) {
+      ++starts[octant(item) + 1];
+    }
+    uint32_t childCount = 0;
+    for (size_t i = 1; i < starts.size(); ++i) {
+      if (starts[i] > 0) {
+        ++childCount;
+      }
+      starts[i] += starts[i - 1];
+    }
+
+    // Group the moving items by octant.
+    std::vector<Item> byOctant(moving.size());
+    std::array<size_t, 9> next = starts;
+    for (const auto& item : moving) {
+      byOctant[next[octant(item)]++] = item;
+    }
+    std::ranges::copy(byOctant, moving.begin());
+
+    // Children are allocated together before recursing so they stay adjacent.
+    auto firstChild = static_cast<uint32_t>(nodes.size());
+    nodes[index].firstChild = firstChild;
+    nodes[index].childCount = childCount;
+    nodes.resize(nodes.size() + childCount);
+
+    std::span<Item> movingItems(moving.begin(), moving.end());
+    uint32_t child = firstChild;
+    for (uint32_t i = 0; i < 8; ++i) {
+      size_t count = starts[i + 1] - starts[i];
+      if (count == 0) {
+        continue;
+      }
+
+      glm::vec3 offset((i & 1u) ? childHalfSize : -childHalfSize,
+                       (i & 2u) ? childHalfSize : -childHalfSize,
+                       (i & 4u) ? childHalfSize : -childHalfSize);
+      buildNode(child, movingItems.subspan(starts[i], count), center + offset,
+                childHalfSize, depth + 1);
+      bounds.grow(nodes[child].bounds);
+      ++child;
+    }
+
+    nodes[index].bounds = bounds;
+    nodes[index].subtreeEnd = static_cast<uint32_t>(boxes.size());
+  }
+} // namespace keptech::maths
@@ -0,0 +1,82 @@
+#pragma once
+
+// Thin wrapper over the widest float vectors the target was compiled for, so
+// the batch kernels can be written once. Defines KT_MATHS_SIMD when one is
+// available; kernels fall back to scalar code otherwise.
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KT_MATHS_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define KT_MATHS_SIMD
+#endif
+
+#ifdef KT_MATHS_SIMD
+namespace keptech::maths::simd {
+#if defined(__AVX2__)
+  using V = __m256;
+  constexpr size_t WIDTH = 8;
+
+  inline V load(const float* from) { return _mm256_loadu_ps(from); }
+  inline V set(float value) { return _mm256_set1_ps(value); }
+  inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+  inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+  inline V bitOr(V a, V b) { return _mm256_or_ps(a, b); }
+  inline V less(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  inline V lessEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+
+  /// One bit per lane, set where the lane of a comparison result is true.
+  inline unsigned mask(V value) {
+    return static_cast<unsigned>(_mm256_movemask_ps(value));
+  }
+
+  inline void storeHalves(V value, float* low, float* high) {
+    _mm_storeu_ps(low, _mm256_castps256_ps128(value));
+    _mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+  }
+
+  /// Transposes four registers and stores the four values of each lane to
+  /// `to(lane)`.
+  template <typename To> void transpose(V a, V b, V c, V d, To to) {
+    V ab0 = _mm256_unpacklo_ps(a, b);
+    V ab1 = _mm256_unpackhi_ps(a, b);
+    V cd0 = _mm256_unpacklo_ps(c, d);
+    V cd1 = _mm256_unpackhi_ps(c, d);
+
+    // Each holds lane n in its low half and lane n + 4 in its high half.
+    storeHalves(_mm256_shuffle_ps(ab0, cd0, 0x44), to(0), to(4));
+    storeHalves(_mm256_shuffle_ps(ab0, cd0, 0xEE), to(1), to(5));
+    storeHalves(_mm256_shuffle_ps(ab1, cd1, 0x44), to(2), to(6));
+    storeHalves(_mm256_shuffle_ps(ab1, cd1, 0xEE), to(3), to(7));
+  }
+#else
+  using V = __m128;
+  constexpr size_t WIDTH = 4;
+
+  inline V load(const float* from) { return _mm_loadu_ps(from); }
+  inline V set(float value) { return _mm_set1_ps(value); }
+  inline V add(V a, V b) { return _mm_add_ps(a, b); }
+  inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+  inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+  inline V bitOr(V a, V b) { return _mm_or_ps(a, b); }
+  inline V less(V a, V b) { return _mm_cmplt_ps(a, b); }
+  inline V lessEqual(V a, V b) { return _mm_cmple_ps(a, b); }
+
+  inline unsigned mask(V value) {
+    return static_cast<unsigned>(_mm_movemask_ps(value));
+  }
+
+  template <typename To> void transpose(V a, V b, V c, V d, To to) {
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    _mm_storeu_ps(to(0), a);
+    _mm_storeu_ps(to(1), b);
+    _mm_storeu_ps(to(2), c);
+    _mm_storeu_ps(to(3), d);
+  }
+#endif
+} // namespace keptech::maths::simd
+#endif
@@ -0,0 +1,221 @@
+#include "keptech/core/maths/transformBatch.hpp"
+
+#include "simd.hpp"
+#include <cassert>
+#include <type_traits>
+
+namespace keptech::maths {
+  namespace {
+    /// Rotation * scale columns, then the translation, without the fourth
+    /// row.
+    using Columns = std::array<std::array<float, 3>, 4>;
+
+    Columns columnsOf(const TransformBatch& batch, size_t i) {
+      float x = batch.rotX[i];
+      float y = batch.rotY[i];
+      float z = batch.rotZ[i];
+      float w = batch.rotW[i];
+
+      float xx = x * x, yy = y * y, zz = z * z;
+      float xy = x * y, xz = x * z, yz = y * z;
+      float wx = w * x, wy = w * y, wz = w * z;
+
+      float sx = batch.scaleX[i];
+      float sy = batch.scaleY[i];
+      float sz = batch.scaleZ[i];
+
+      return {{
+          {(1.0f - 2.0f * (yy + zz)) * sx, 2.0f * (xy + wz) * sx,
+           2.0f * (xz - wy) * sx},
+          {2.0f * (xy - wz) * sy, (1.0f - 2.0f * (xx + zz)) * sy,
+           2.0f * (yz + wx) * sy},
+          {2.0f * (xz + wy) * sz, 2.0f * (yz - wx) * sz,
+           (1.0f - 2.0f * (xx + yy)) * sz},
+          {batch.posX[i], batch.posY[i], batch.posZ[i]},
+      }};
+    }
+
+    void store(const Columns& columns, glm::mat4& out) {
+      for (glm::length_t column = 0; column < 4; ++column) {
+        const auto& values = columns[static_cast<size_t>(column)];
+        out[column] = glm::vec4(values[0], values[1], values[2],
+                                column == 3 ? 1.0f : 0.0f);
+      }
+    }
+
+    void store(const Columns& columns, Matrix3x4& out) {
+      for (size_t row = 0; row < 3; ++row) {
+        out.rows[row] = glm::vec4(columns[0][row], columns[1][row],
+                                  columns[2][row], columns[3][row]);
+      }
+    }
+
+#ifdef KT_MATHS_SIMD
+    /// Columns as in `Columns`, one transform per lane. A plain array, as
+    /// std::array drops the vector type's alignment attributes.
+    struct SimdColumns {
+      simd::V values[4][3];
+    };
+
+    /// Runs the kernel over whole groups of `simd::WIDTH` transforms, handing
+    /// each group's columns to `store`. Returns the number of transforms
+    /// done.
+    template <typename Store>
+    size_t toColumnsSimd(const TransformBatch& batch, Store store) {
+      const simd::V one = simd::set(1.0f);
+      const simd::V two = simd::set(2.0f);
+
+      size_t i = 0;
+      for (; i + simd::WIDTH <= batch.size(); i += simd::WIDTH) {
+        simd::V x = simd::load(&batch.rotX[i]);
+        simd::V y = simd::load(&batch.rotY[i]);
+        simd::V z = simd::load(&batch.rotZ[i]);
+        simd::V w = simd::load(&batch.rotW[i]);
+
+        simd::V xx = simd::mul(x, x), yy = simd::mul(y, y);
+        simd::V zz = simd::mul(z, z), xy = simd::mul(x, y);
+        simd::V xz = simd::mul(x, z), yz = simd::mul(y, z);
+        simd::V wx = simd::mul(w, x), wy = simd::mul(w, y);
+        simd::V wz = simd::mul(w, z);
+
+        simd::V sx = simd::load(&batch.scaleX[i]);
+        simd::V sy = simd::load(&batch.scaleY[i]);
+        simd::V sz = simd::load(&batch.scaleZ[i]);
+
+        auto diagonal = [&](simd::V a, simd::V b, simd::V scale) {
+          return simd::mul(simd::sub(one, simd::mul(two, simd::add(a, b))),
+                           scale);
+        };
+        auto twice = [&](simd::V value, simd::V scale) {
+          return simd::mul(simd::mul(two, value), scale);
+        };
+
+        SimdColumns columns{{
+            {diagonal(yy, zz, sx), twice(simd::add(xy, wz), sx),
+             twice(simd::sub(xz, wy), sx)},
+            {twice(simd::sub(xy, wz), sy), diagonal(xx, zz, sy),
+             twice(simd::add(yz, wx), sy)},
+            {twice(simd::add(xz, wy), sz), twice(simd::sub(yz, wx), sz),
+             diagonal(xx, yy, sz)},
+            {simd::load(&batch.posX[i]), simd::load(&batch.posY[i]),
+             simd::load(&batch.posZ[i])},
+        }};
+
+        store(i, columns);
+      }
+
+      return i;
+    }
+#endif
+
+    template <typename Out>
+    void toMatricesImpl(const TransformBatch& batch, std::span<Out> out) {
+      assert(out.size() >= batch.size() && "Output span is too small.");
+
+      size_t done = 0;
+#ifdef KT_MATHS_SIMD
+      if constexpr (std::is_same_v<Out, glm::mat4>) {
+        const simd::V zero = simd::set(0.0f);
+        const simd::V one = simd::set(1.0f);
+
+        done = toColumnsSimd(batch, [&](size_t base,
+                                        const SimdColumns& columns) {
+          for (glm::length_t column = 0; column < 4; ++column) {
+            const auto& values = columns.values[column];
+            simd::transpose(values[0], values[1], values[2],
+                            column == 3 ? one : zero, [&](size_t lane) {
+                              return &out[base + lane][column][0];
+                            });
+          }
+        });
+      } else {
+        done = toColumnsSimd(batch, [&](size_t base,
+                                        const SimdColumns& columns) {
+          for (size_t row = 0; row < 3; ++row) {
+            const auto& values = columns.values;
+            simd::transpose(values[0][row], values[1][row], values[2][row],
+                            values[3][row], [&](size_t lane) {
+                              return &out[base + lane].rows[row][0];
+                            });
+          }
+        });
+      }
+#endif
+
+      for (size_t i = done; i < batch.size(); ++i) {
+        store(columnsOf(batch, i), out[i]);
+      }
+    }
+  } // namespace
+
+  void toMatrices(const TransformBatch& batch, std::span<glm::mat4> out) {
+    toMatricesImpl(batch, out);
+  }
+
+  void toMatrices(const TransformBatch& batch, std::span<Matrix3x4> out) {
+    toMatricesImpl(batch, out);
+  }
+
+  void multiplyMatrices(std::span<const glm::mat4> parents,
+                        std::span<const glm::mat4> locals,
+                        std::span<glm::mat4> out) {
+    assert(parents.size() == locals.size() && out.size() >= locals.size() &&
+           "Mismatched matrix spans.");
+
+    for (size_t i = 0; i < locals.size(); ++i) {
+#if defined(__AVX2__)
+      // Two result columns per register. Every column of the product is the
+      // parent's columns weighted by one column of the local matrix.
+      auto parentColumn = [&](glm::length_t column) {
+        __m128 value = _mm_loadu_ps(&parents[i][column][0]);
+        return _mm256_set_m128(value, value);
+      };
+      __m256 p0 = parentColumn(0);
+      __m256 p1 = parentColumn(1);
+      __m256 p2 = parentColumn(2);
+      __m256 p3 = parentColumn(3);
+
+      __m256 l01 = _mm256_loadu_ps(&locals[i][0][0]);
+      __m256 l23 = _mm256_loadu_ps(&locals[i][2][0]);
+
+      auto combine = [&](__m256 local) {
+        __m256 result = _mm256_mul_ps(p0, _mm256_permute_ps(local, 0x00));
+        result = _mm256_add_ps(
+            result, _mm256_mul_ps(p1, _mm256_permute_ps(local, 0x55)));
+        result = _mm256_add_ps(
+            result, _mm256_mul_ps(p2, _mm256_permute_ps(local, 0xAA)));
+        return _mm256_add_ps(
+            result, _mm256_mul_ps(p3, _mm256_permute_ps(local, 0xFF)));
+      };
+      __m256 r01 = combine(l01);
+      __m256 r23 = combine(l23);
+
+      _mm256_storeu_ps(&out[i][0][0], r01);
+      _mm256_storeu_ps(&out[i][2][0], r23);
+#elif defined(KT_MATHS_SIMD)
+      __m128 p0 = _mm_loadu_ps(&parents[i][0][0]);
+      __m128 p1 = _mm_loadu_ps(&parents[i][1][0]);
+      __m128 p2 = _mm_loadu_ps(&parents[i][2][0]);
+      __m128 p3 = _mm_loadu_ps(&parents[i][3][0]);
+
+      __m128 local[4] = {
+          _mm_loadu_ps(&locals[i][0][0]),
+          _mm_loadu_ps(&locals[i][1][0]),
+          _mm_loadu_ps(&locals[i][2][0]),
+          _mm_loadu_ps(&locals[i][3][0]),
+      };
+
+      for (glm::length_t column = 0; column < 4; ++column) {
+        __m128 l = local[column];
+        __m128 result = _mm_mul_ps(p0, _mm_shuffle_ps(l, l, 0x00));
+        result = _mm_add_ps(result, _mm_mul_ps(p1, _mm_shuffle_ps(l, l, 0x55)));
+        result = _mm_add_ps(result, _mm_mul_ps(p2, _mm_shuffle_ps(l, l, 0xAA)));
+        result = _mm_add_ps(result, _mm_mul_ps(p3, _mm_shuffle_ps(l, l, 0xFF)));
+        _mm_storeu_ps(&out[i][column][0], result);
+      }
+#else
+      out[i] = parents[i] * locals[i];
+#endif
+    }
+  }
+} // namespace keptech::maths
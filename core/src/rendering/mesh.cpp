@@ -0,0 +1,30 @@
+#include "keptech/core/rendering/mesh.hpp"
+
+#include <cassert>
+
+namespace keptech::core::rendering {
+  keptech::maths::Bounds computeBounds(std::span<const Mesh::Vertex> vertices,
+                                       std::span<const uint32_t> indices,
+                                       std::span<Mesh::Submesh> submeshes) {
+    for (auto& submesh : submeshes) {
+      if (indices.empty()) {
+        assert(submesh.indexOffset + submesh.indexCount <= vertices.size() &&
+               "Submesh out of vertex range.");
+        submesh.bounds = keptech::maths::Bounds::enclosing(
+            vertices.subspan(submesh.indexOffset, submesh.indexCount),
+            &Mesh::Vertex::position);
+      } else {
+        assert(submesh.indexOffset + submesh.indexCount <= indices.size() &&
+               "Submesh out of index range.");
+        submesh.bounds = keptech::maths::Bounds::enclosing(
+            indices.subspan(submesh.indexOffset, submesh.indexCount),
+            [&](uint32_t index) -> const glm::vec3& {
+              return vertices[index].position;
+            });
+      }
+    }
+
+    return keptech::maths::Bounds::enclosing(vertices,
+                                             &Mesh::Vertex::position);
+  }
+} // namespace keptech::core::rendering
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "base.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace keptech::ecs {
+  /// Type-erased operations needed to move components between chunks.
+  struct ComponentInfo {
+    size_t size = 0;
+    size_t alignment = 0;
+    /// Move constructs the component at `dst` from `src`, then destroys `src`.
+    void (*relocate)(void* dst, void* src) = nullptr;
+    void (*destroy)(void* ptr) = nullptr;
+
+    template <typename T> static ComponentInfo of() {
+      return ComponentInfo{
+          .size = sizeof(T),
+          .alignment = alignof(T),
+          .relocate =
+              [](void* dst, void* src) {
+                T* from = static_cast<T*>(src);
+                new (dst) T(std::move(*from));
+                from->~T();
+              },
+          .destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); },
+      };
+    }
+  };
+
+  /// Storage for every entity whose signature is exactly `signature`.
+  /// Rows live in fixed-size chunks. Each chunk holds the owning entities
+  /// followed by one packed column per component (SoA), so a system can walk a
+  /// chunk column by column.
+  class Archetype {
+  public:
+    constexpr static size_t CHUNK_SIZE = 16 * 1024;
+    constexpr static size_t CHUNK_ALIGNMENT = 64;
+    constexpr static uint8_t NO_COLUMN = UINT8_MAX;
+
+    struct Column {
+      ComponentType type;
+      ComponentInfo info;
+      size_t offset;
+    };
+
+    struct Row {
+      uint32_t chunk = 0;
+      uint32_t index = 0;
+    };
+
+    Archetype(const Signature& archetypeSignature,
+              const std::array<ComponentInfo, MAX_COMPONENTS>& infos);
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+    Archetype(Archetype&&) = delete;
+    Archetype& operator=(Archetype&&) = delete;
+    ~Archetype();
+
+    [[nodiscard]] const Signature& getSignature() const { return signature; }
+
+    /// Reserves a row for the entity. The component memory of the row is left
+    /// uninitialised for the caller to construct into.
+    Row allocate(EntityHandle entity);
+
+    /// Removes a row whose components have already been destroyed or moved
+    /// out, by moving the last row into it. Returns the entity that now
+    /// occupies `row`, or INVALID_ENTITY_HANDLE if nothing was moved.
+    EntityHandle removeRow(Row row);
+
+    [[nodiscard]] uint8_t columnOf(ComponentType type) const {
+      return columnLookup[type];
+    }
+
+    [[nodiscard]] std::span<const Column> getColumns() const {
+      return columns;
+    }
+
+    [[nodiscard]] void* component(uint8_t column, Row row) const {
+      return chunks[row.chunk].data + columns[column].offset +
+             (columns[column].info.size * row.index);
+    }
+
+    template <typename T>
+    [[nodiscard]] T* columnData(uint8_t column, size_t chunk) const {
+      return std::launder(
+          reinterpret_cast<T*>(chunks[chunk].data + columns[column].offset));
+    }
+
+    [[nodiscard]] EntityHandle* entities(size_t chunk) const {
+      return reinterpret_cast<EntityHandle*>(chunks[chunk].data);
+    }
+
+    [[nodiscard]] size_t chunkCount() const { return chunks.size(); }
+    [[nodiscard]] uint32_t chunkSize(size_t chunk) const {
+      return chunks[chunk].count;
+    }
+    [[nodiscard]] size_t getCapacity() const { return capacity; }
+    [[nodiscard]] size_t size() const { return rowCount; }
+
+    /// Cached neighbour archetypes, one component added or removed.
+    Archetype*& addEdge(ComponentType type) { return addEdges[type]; }
+    Archetype*& removeEdge(ComponentType type) { return removeEdges[type]; }
+
+  private:
+    struct Chunk {
+      std::byte* data = nullptr;
+      uint32_t count = 0;
+    };
+
+    Signature signature;
+    std::vector<Column> columns;
+    std::array<uint8_t, MAX_COMPONENTS> columnLookup{};
+    size_t capacity = 0;
+    size_t rowCount = 0;
+
+    std::vector<Chunk> chunks;
+
+    std::array<Archetype*, MAX_COMPONENTS> addEdges{};
+    std::array<Archetype*, MAX_COMPONENTS> removeEdges{};
+  };
+} // namespace keptech::ecs
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "archetype.hpp"
+#include "ecs-logger.hpp"
+#include "threadPool.hpp"
+#include "typeIndex.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace keptech::ecs {
+  /// Iterates every entity that owns all of `Ts`, one archetype chunk at a
+  /// time. Matching archetypes are gathered when the view is made, so the view
+  /// should be short lived.
+  ///
+  /// Adding or removing any component on any entity while iterating
+  /// invalidates the view, as rows move between chunks.
+  template <typename... Ts> class ArchetypeView {
+    static_assert(sizeof...(Ts) > 0, "A view needs at least one component.");
+
+    using Columns = std::array<uint8_t, sizeof...(Ts)>;
+
+  public:
+    using Item = std::tuple<EntityHandle, Ts&...>;
+
+    ArchetypeView(const std::vector<Archetype*>& all,
+                  const std::array<ComponentType, sizeof...(Ts)>& types,
+                  ThreadPool* jobPool = nullptr)
+        : pool(jobPool) {
+      Signature required;
+      for (auto type : types) {
+        required.set(type);
+      }
+
+      for (Archetype* archetype : all) {
+        if ((archetype->getSignature() & required) != required ||
+            archetype->size() == 0) {
+          continue;
+        }
+
+        Columns columns{};
+        for (size_t i = 0; i < types.size(); ++i) {
+          columns[i] = archetype->columnOf(types[i]);
+        }
+        matches.push_back(Match{.archetype = archetype, .columns = columns});
+      }
+    }
+
+    /// Calls `fn(entity, components...)` or `fn(components...)` for every
+    /// matching entity.
+    template <typename Fn> void each(Fn&& fn) const {
+      eachChunk([&fn](size_t count, const EntityHandle* entities,
+                      Ts*... components) {
+        for (size_t i = 0; i < count; ++i) {
+          if constexpr (std::is_invocable_v<Fn&, EntityHandle, Ts&...>) {
+            fn(entities[i], components[i]...);
+          } else {
+            fn(components[i]...);
+          }
+        }
+      });
+    }
+
+    /// Calls `fn(count, entities, columns...)` for every matching chunk, where
+    /// each column points at `count` packed components.
+    template <typename Fn> void eachChunk(Fn&& fn) const {
+      for (const auto& match : matches) {
+        for (size_t chunk = 0; chunk < match.archetype->chunkCount();
+             ++chunk) {
+          invokeChunk(fn, match, chunk, std::index_sequence_for<Ts...>{});
+        }
+      }
+    }
+
+    /// Like `each`, but runs batches of at most `grainSize` rows of a chunk on
+    /// the thread pool, returning once all are done. `fn` is called
+    /// concurrently, so it must only write to the components it is given or to
+    /// per-thread state, see `ThreadPool::threadIndex`.
+    template <typename Fn>
+    void parallelForEach(Fn&& fn, size_t grainSize = 256) const {
+      if (!pool || sizeHint() <= grainSize) {
+        each(fn);
+        return;
+      }
+
+      JobGroup group;
+      eachChunk([&](size_t count, const EntityHandle* entities,
+                    Ts*... components) {
+        for (size_t begin = 0; begin < count; begin += grainSize) {
+          size_t end = std::min(begin + grainSize, count);
+          pool->submit(
+              [&fn, begin, end, entities, components...] {
+                for (size_t i = begin; i < end; ++i) {
+                  if constexpr (std::is_invocable_v<Fn&, EntityHandle,
+                                                    Ts&...>) {
+                    fn(entities[i], components[i]...);
+                  } else {
+                    fn(components[i]...);
+                  }
+                }
+              },
+              group);
+        }
+      });
+      pool->wait(group);
+    }
+
+    class Iterator {
+    public:
+      using difference_type = std::ptrdiff_t;
+      using value_type = Item;
+
+      Iterator() = default;
+      Iterator(const ArchetypeView* owner, size_t start)
+          : view(owner), match(start) {
+        skip();
+      }
+
+      Item operator*() const {
+        return view->fetch(view->matches[match], row,
+                           std::index_sequence_for<Ts...>{});
+      }
+
+      Iterator& operator++() {
+        ++row.index;
+        skip();
+        return *this;
+      }
+
+      Iterator operator++(int) {
+        Iterator copy = *this;
+        ++*this;
+        return copy;
+      }
+
+      bool operator==(const Iterator& other) const {
+        return match == other.match && row.chunk == other.row.chunk &&
+               row.index == other.row.index;
+      }
+
+    private:
+      void skip() {
+        while (match < view->matches.size()) {
+          const Archetype& archetype = *view->matches[match].archetype;
+          if (row.chunk < archetype.chunkCount() &&
+              row.index < archetype.chunkSize(row.chunk)) {
+            return;
+          }
+
+          row.index = 0;
+          if (++row.chunk >= archetype.chunkCount()) {
+            row.chunk = 0;
+            ++match;
+          }
+        }
+      }
+
+      const ArchetypeView* view = nullptr;
+      size_t match = 0;
+      Archetype::Row row{};
+    };
+
+    [[nodiscard]] Iterator begin() const { return Iterator(this, 0); }
+    [[nodiscard]] Iterator end() const {
+      return Iterator(this, matches.size());
+    }
+
+    /// Exact number of entities the view will visit.
+    [[nodiscard]] size_t sizeHint() const {
+      size_t count = 0;
+      for (const auto& match : matches) {
+        count += match.archetype->size();
+      }
+      return count;
+    }
+
+  private:
+    struct Match {
+      Archetype* archetype;
+      Columns columns;
+    };
+
+    template <typename Fn, size_t... Is>
+    static void invokeChunk(Fn& fn, const Match& match, size_t chunk,
+                            std::index_sequence<Is...> /*unused*/) {
+      fn(static_cast<size_t>(match.archetype->chunkSize(chunk)),
+         static_cast<const EntityHandle*>(match.archetype->entities(chunk)),
+         match.archetype->template columnData<std::remove_const_t<Ts>>(
+             match.columns[Is], chunk)...);
+    }
+
+    template <size_t... Is>
+    Item fetch(const Match& match, Archetype::Row row,
+               std::index_sequence<Is...> /*unused*/) const {
+      return Item{match.archetype->entities(row.chunk)[row.index],
+                  *static_cast<std::remove_const_t<Ts>*>(
+                      match.archetype->component(match.columns[Is], row))...};
+    }
+
+    std::vector<Match> matches;
+    ThreadPool* pool = nullptr;
+  };
+
+  /// Archetype component storage.
+  /// Every entity lives in the archetype matching its signature, with all of
+  /// its components in one chunk row. Adding or removing a component moves
+  /// the row to the neighbouring archetype, which is cached on the archetype
+  /// as an edge after the first move.
+  class ArchetypeManager {
+  public:
+    ArchetypeManager() = default;
+    ArchetypeManager(const ArchetypeManager&) = delete;
+    ArchetypeManager& operator=(const ArchetypeManager&) = delete;
+    ArchetypeManager(ArchetypeManager&&) = delete;
+    ArchetypeManager& operator=(ArchetypeManager&&) = delete;
+    ~ArchetypeManager() = default;
+
+    template <typename T> ComponentType getComponentType() {
+      ComponentType type = componentTypeOf<T>();
+
+      if (!registered[type].load(std::memory_order_acquire)) [[unlikely]] {
+        registerComponent<T>(type);
+      }
+
+      return type;
+    }
+
+    template <typename T>
+    ArchetypeManager& add(EntityHandle entity, T&& component) {
+      using U = std::remove_cvref_t<T>;
+      ComponentType type = getComponentType<U>();
+      Archetype* current = location(entity).archetype;
+
+      assert(!(current && current->getSignature().test(type)) &&
+             "Component added to same entity more than once.");
+
+      Archetype* target = withComponent(current, type);
+      Archetype::Row row = moveEntity(entity, target);
+      new (target->component(target->columnOf(type), row))
+          U(std::forward<T>(component));
+      return *this;
+    }
+
+    template <typename T> ArchetypeManager& remove(EntityHandle entity) {
+      ComponentType type = getComponentType<T>();
+      Archetype* current = location(entity).archetype;
+
+      assert(current && current->getSignature().test(type) &&
+             "Removing non-existent component.");
+
+      moveEntity(entity, withoutComponent(current, type));
+      return *this;
+    }
+
+    template <typename T> bool has(EntityHandle entity) {
+      ComponentType type = getComponentType<T>();
+      const Location* loc = find(entity);
+      return loc && loc->archetype->getSignature().test(type);
+    }
+
+    template <typename T> T& at(EntityHandle entity) {
+      T* component = get<T>(entity);
+      assert(component && "Retrieving non-existent component.");
+      return *component;
+    }
+
+    template <typename T> T* get(EntityHandle entity) {
+      ComponentType type = getComponentType<T>();
+      const Location* loc = find(entity);
+      if (!loc || !loc->archetype->getSignature().test(type)) {
+        return nullptr;
+      }
+
+      uint8_t column = loc->archetype->columnOf(type);
+      return static_cast<T*>(loc->archetype->component(column, loc->row));
+    }
+
+    void onEntityDestroyed(EntityHandle entity);
+
+    template <typename... Ts>
+    ArchetypeView<Ts...> view(ThreadPool* pool = nullptr) {
+      return ArchetypeView<Ts...>(
+          archetypeList, {getComponentType<std::remove_const_t<Ts>>()...},
+          pool);
+    }
+
+    [[nodiscard]] const std::vector<Archetype*>& getArchetypes() const {
+      return archetypeList;
+    }
+
+  private:
+    struct Location {
+      EntityHandle entity = INVALID_ENTITY_HANDLE;
+      Archetype* archetype = nullptr;
+      Archetype::Row row{};
+    };
+
+    /// Types are registered on first use, which may be from systems running
+    /// in parallel, so registration is serialised and published through
+    /// `registered`.
+    template <typename T> void registerComponent(ComponentType type) {
+      std::scoped_lock lock(registerMutex);
+      if (registered[type].load(std::memory_order_relaxed)) {
+        return;
+      }
+
+      ECS_DEBUG("Registering component type: {}", typeid(T).name());
+
+      componentInfos[type] = ComponentInfo::of<T>();
+      registered[type].store(true, std::memory_order_release);
+    }
+
+    /// Location of a live entity with at least one component, or nullptr.
+    [[nodiscard]] const Location* find(EntityHandle entity) const {
+      EntityIndex index = entityIndex(entity);
+      if (index >= locations.size() || locations[index].entity != entity ||
+          !locations[index].archetype) {
+        return nullptr;
+      }
+      return &locations[index];
+    }
+
+    Location& location(EntityHandle entity) {
+      EntityIndex index = entityIndex(entity);
+      if (index >= locations.size()) {
+        locations.resize(static_cast<size_t>(index) + 1);
+      }
+
+      Location& loc = locations[index];
+      if (loc.entity != entity) {
+        assert(!loc.archetype && "Stale entity handle used.");
+        loc.entity = entity;
+      }
+      return loc;
+    }
+
+    Archetype* archetypeFor(const Signature& signature);
+    Archetype* withComponent(Archetype* from, ComponentType type);
+    Archetype* withoutComponent(Archetype* from, ComponentType type);
+
+    /// Moves the entity's row into `target`, carrying over every component the
+    /// target stores and destroying the rest. A null target drops the row.
+    /// Returns the new row.
+    Archetype::Row moveEntity(EntityHandle entity, Archetype* target);
+
+    std::array<ComponentInfo, MAX_COMPONENTS> componentInfos{};
+    std::array<std::atomic<bool>, MAX_COMPONENTS> registered{};
+    std::mutex registerMutex;
+
+    std::unordered_map<Signature, std::unique_ptr<Archetype>> archetypes{};
+    std::vector<Archetype*> archetypeList{};
+    std::vector<Location> locations{};
+  };
+} // namespace keptech::ecs
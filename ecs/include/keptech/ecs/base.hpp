@@ -1,11 +1,49 @@
 #pragma once
 
 #include <bitset>
+#include <cstddef>
+#include <cstdint>
 
 namespace keptech::ecs {
-  using EntityHandle = uint16_t;
-  constexpr EntityHandle MAX_ENTITIES = 5000;
-  constexpr EntityHandle INVALID_ENTITY_HANDLE = UINT16_MAX;
+  /// Entity handles pack a slot index in the low bits and a generation in the
+  /// high bits. The generation is bumped whenever a slot is freed, so a handle
+  /// kept past `destroyEntity` no longer matches the slot's new occupant.
+  using EntityHandle = uint32_t;
+  using EntityIndex = uint32_t;
+  using EntityGeneration = uint16_t;
+
+  constexpr uint32_t ENTITY_INDEX_BITS = 20;
+  constexpr uint32_t ENTITY_GENERATION_BITS = 12;
+  constexpr EntityHandle ENTITY_INDEX_MASK = (1U << ENTITY_INDEX_BITS) - 1;
+  constexpr EntityHandle ENTITY_GENERATION_MASK =
+      (1U << ENTITY_GENERATION_BITS) - 1;
+
+  constexpr EntityHandle INVALID_ENTITY_HANDLE = UINT32_MAX;
+
+  /// Hard limit on live entities. The all-ones index is reserved for
+  /// INVALID_ENTITY_HANDLE. Can be lowered per build with KEPTECH_MAX_ENTITIES,
+  /// or per EntityManager at runtime.
+#ifdef KEPTECH_MAX_ENTITIES
+  constexpr size_t MAX_ENTITIES = KEPTECH_MAX_ENTITIES;
+#else
+  constexpr size_t MAX_ENTITIES = ENTITY_INDEX_MASK;
+#endif
+  static_assert(MAX_ENTITIES <= ENTITY_INDEX_MASK,
+                "MAX_ENTITIES does not fit in the entity index bits.");
+
+  constexpr EntityIndex entityIndex(EntityHandle entity) {
+    return entity & ENTITY_INDEX_MASK;
+  }
+
+  constexpr EntityGeneration entityGeneration(EntityHandle entity) {
+    return static_cast<EntityGeneration>(entity >> ENTITY_INDEX_BITS);
+  }
+
+  constexpr EntityHandle makeEntityHandle(EntityIndex index,
+                                          EntityGeneration generation) {
+    return (static_cast<EntityHandle>(generation) << ENTITY_INDEX_BITS) |
+           (index & ENTITY_INDEX_MASK);
+  }
 
   using ComponentType = uint8_t;
   constexpr ComponentType MAX_COMPONENTS = 64;
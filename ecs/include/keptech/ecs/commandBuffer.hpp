@@ -0,0 +1,155 @@
+#pragma once
+
+#include "base.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace keptech::ecs {
+  class ECS;
+
+  /// Stand-in for an entity created through an EntityCommandBuffer, valid
+  /// until the buffer is played back.
+  struct PendingEntity {
+    uint32_t index;
+  };
+
+  /// Records structural changes to apply later, at a point where nothing is
+  /// iterating the ECS. Recording is thread safe, so jobs may record into the
+  /// same buffer.
+  ///
+  /// Playback applies the commands in the order they were recorded, then
+  /// updates system membership once for every entity whose components
+  /// changed. Systems never see an entity that is created and destroyed in
+  /// the same playback, nor components an entity gains before it is
+  /// destroyed.
+  class EntityCommandBuffer {
+  public:
+    /// Where a command applies: a live entity, or one created earlier in the
+    /// same buffer.
+    struct Target {
+      constexpr static uint32_t NOT_PENDING = UINT32_MAX;
+
+      EntityHandle entity = INVALID_ENTITY_HANDLE;
+      uint32_t pending = NOT_PENDING;
+
+      Target(EntityHandle live) : entity(live) {}
+      Target(PendingEntity created) : pending(created.index) {}
+    };
+
+    /// State shared by the commands of one playback.
+    struct Playback {
+      ECS& ecs;
+      std::vector<EntityHandle> created;
+      /// Entities whose components changed, with their signature before
+      /// playback.
+      std::unordered_map<EntityHandle, Signature> changed;
+
+      [[nodiscard]] EntityHandle resolve(const Target& target) const {
+        return target.pending == Target::NOT_PENDING
+                   ? target.entity
+                   : created[target.pending];
+      }
+    };
+
+    struct Command {
+      Command() = default;
+      Command(const Command&) = delete;
+      Command& operator=(const Command&) = delete;
+      Command(Command&&) = delete;
+      Command& operator=(Command&&) = delete;
+      virtual ~Command() = default;
+
+      virtual void apply(Playback& playback) = 0;
+    };
+
+    struct CreateCommand final : Command {
+      explicit CreateCommand(std::string entityName)
+          : name(std::move(entityName)) {}
+      void apply(Playback& playback) override;
+
+      std::string name;
+    };
+
+    struct DestroyCommand final : Command {
+      explicit DestroyCommand(Target destroyed) : target(destroyed) {}
+      void apply(Playback& playback) override;
+
+      Target target;
+    };
+
+    template <typename T> struct AddCommand final : Command {
+      AddCommand(Target entity, T&& added)
+          : target(entity), component(std::move(added)) {}
+      void apply(Playback& playback) override;
+
+      Target target;
+      T component;
+    };
+
+    template <typename T> struct RemoveCommand final : Command {
+      explicit RemoveCommand(Target entity) : target(entity) {}
+      void apply(Playback& playback) override;
+
+      Target target;
+    };
+
+    EntityCommandBuffer() = default;
+    EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+    EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+    EntityCommandBuffer(EntityCommandBuffer&&) = delete;
+    EntityCommandBuffer& operator=(EntityCommandBuffer&&) = delete;
+    ~EntityCommandBuffer() = default;
+
+    PendingEntity createEntity(std::string name) {
+      std::scoped_lock lock(mutex);
+      commands.push_back(std::make_unique<CreateCommand>(std::move(name)));
+      return PendingEntity{pendingCount++};
+    }
+
+    void destroyEntity(Target entity) {
+      record(std::make_unique<DestroyCommand>(entity));
+    }
+
+    template <typename T> void addComponent(Target entity, T&& component) {
+      using U = std::remove_cvref_t<T>;
+      record(std::make_unique<AddCommand<U>>(
+          entity, U(std::forward<T>(component))));
+    }
+
+    template <typename T> void removeComponent(Target entity) {
+      record(std::make_unique<RemoveCommand<T>>(entity));
+    }
+
+    /// Drops every recorded command without applying it.
+    void clear() {
+      std::scoped_lock lock(mutex);
+      commands.clear();
+      pendingCount = 0;
+    }
+
+    [[nodiscard]] bool empty() {
+      std::scoped_lock lock(mutex);
+      return commands.empty();
+    }
+
+    /// Applies and clears every recorded command. Commands recorded while
+    /// playing back are kept for the next playback.
+    void playback(ECS& ecs);
+
+  private:
+    void record(std::unique_ptr<Command>&& command) {
+      std::scoped_lock lock(mutex);
+      commands.push_back(std::move(command));
+    }
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Command>> commands;
+    uint32_t pendingCount = 0;
+  };
+} // namespace keptech::ecs
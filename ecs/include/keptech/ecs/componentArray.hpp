@@ -1,73 +1,85 @@
 #pragma once
 
 #include "base.hpp"
-#include <unordered_map>
+#include "sparseSet.hpp"
+#include <cassert>
+#include <span>
+#include <vector>
 
 namespace keptech::ecs {
 
-  class IComponentArray {};
+  class IComponentArray {
+  public:
+    IComponentArray() = default;
+    IComponentArray(const IComponentArray&) = delete;
+    IComponentArray& operator=(const IComponentArray&) = delete;
+    IComponentArray(IComponentArray&&) noexcept = default;
+    IComponentArray& operator=(IComponentArray&&) noexcept = default;
+    virtual ~IComponentArray() = default;
+  };
 
+  /// Sparse-set component storage.
+  /// Components are packed in `components`, with the owning entity of each at
+  /// the same index in `entitySet`, so a lookup is one sparse page read and
+  /// iteration is a linear walk.
   template <typename T> class ComponentArray : public IComponentArray {
   public:
-    ComponentArray() { components.reserve(MAX_ENTITIES); }
+    ComponentArray() = default;
 
     void insert(EntityHandle entity, T&& component) {
-      assert(entityToIndexMap.find(entity) == entityToIndexMap.end() &&
+      assert(!entitySet.contains(entity) &&
              "Component added to same entity more than once.");
-
-      size_t newIndex = components.size();
-      assert(newIndex < MAX_ENTITIES &&
+      assert(components.size() < MAX_ENTITIES &&
              "Too many components stored in ComponentArray.");
-      components.emplace_back(std::move(component));
 
-      entityToIndexMap[entity] = newIndex;
-      indexToEntityMap[newIndex] = entity;
+      entitySet.insert(entity);
+      components.emplace_back(std::move(component));
     }
 
     void erase(EntityHandle entity) {
-      assert(entityToIndexMap.find(entity) != entityToIndexMap.end() &&
-             "Removing non-existent component.");
+      assert(entitySet.contains(entity) && "Removing non-existent component.");
 
-      size_t indexOfRemovedEntity = entityToIndexMap[entity];
-      assert(indexOfRemovedEntity < components.size() && "Attempting to erase "
-                                                         "component at invalid "
-                                                         "index.");
+      size_t indexOfRemovedEntity = entitySet.erase(entity);
       size_t indexOfLastElement = components.size() - 1;
-      components[indexOfRemovedEntity] =
-          std::move(components[indexOfLastElement]);
-
-      EntityHandle entityOfLastElement = indexToEntityMap[indexOfLastElement];
-      entityToIndexMap[entityOfLastElement] = indexOfRemovedEntity;
-      indexToEntityMap[indexOfRemovedEntity] = entityOfLastElement;
-
+      if (indexOfRemovedEntity != indexOfLastElement) {
+        components[indexOfRemovedEntity] =
+            std::move(components[indexOfLastElement]);
+      }
       components.pop_back();
-      entityToIndexMap.erase(entity);
-      indexToEntityMap.erase(indexOfLastElement);
     }
 
     [[nodiscard]] bool has(EntityHandle entity) const {
-      return entityToIndexMap.find(entity) != entityToIndexMap.end();
+      return entitySet.contains(entity);
     }
 
     [[nodiscard]] T& at(EntityHandle entity) {
-      assert(entityToIndexMap.find(entity) != entityToIndexMap.end() &&
+      auto index = entitySet.indexOf(entity);
+      assert(index != SparseSet::INVALID_INDEX &&
              "Retrieving non-existent component.");
 
-      return components[entityToIndexMap[entity]];
+      return components[index];
     }
 
     [[nodiscard]] T* get(EntityHandle entity) {
-      if (!entityToIndexMap.contains(entity)) {
+      auto index = entitySet.indexOf(entity);
+      if (index == SparseSet::INVALID_INDEX) {
         return nullptr;
       }
 
-      return &components[entityToIndexMap[entity]];
+      return &components[index];
     }
 
     [[nodiscard]] T& operator[](EntityHandle entity) { return at(entity); }
 
+    /// Component at the given packed index, see `getEntities`.
+    [[nodiscard]] T& atIndex(size_t index) { return components[index]; }
+
     auto getDeleteCallback() {
-      return [this](EntityHandle entity) { this->erase(entity); };
+      return [this](EntityHandle entity) {
+        if (this->has(entity)) {
+          this->erase(entity);
+        }
+      };
     }
 
     [[nodiscard]] size_t size() const { return components.size(); }
@@ -76,6 +88,13 @@ namespace keptech::ecs {
       return components;
     }
 
+    /// Entities owning each component, in the same order as the components.
+    [[nodiscard]] std::span<const EntityHandle> getEntities() const {
+      return entitySet.entities();
+    }
+
+    [[nodiscard]] const SparseSet& getEntitySet() const { return entitySet; }
+
     std::vector<T>::iterator begin() { return components.begin(); }
     std::vector<T>::iterator end() { return components.end(); }
     std::vector<T>::const_iterator begin() const { return components.cbegin(); }
@@ -87,7 +106,6 @@ namespace keptech::ecs {
 
   private:
     std::vector<T> components;
-    std::unordered_map<EntityHandle, size_t> entityToIndexMap;
-    std::unordered_map<size_t, EntityHandle> indexToEntityMap;
+    SparseSet entitySet;
   };
 } // namespace keptech::ecs
@@ -2,29 +2,25 @@
 
 #include "componentArray.hpp"
 #include "ecs-logger.hpp"
+#include "typeIndex.hpp"
+#include "view.hpp"
+#include <array>
+#include <atomic>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
 
 namespace keptech::ecs {
   class ComponentManager {
-    using TypeHash = size_t;
-
   public:
     ComponentManager() = default;
     ComponentManager(const ComponentManager&) = delete;
     ComponentManager& operator=(const ComponentManager&) = delete;
-    ComponentManager(ComponentManager&&) noexcept = default;
-    ComponentManager& operator=(ComponentManager&&) noexcept = default;
+    ComponentManager(ComponentManager&&) = delete;
+    ComponentManager& operator=(ComponentManager&&) = delete;
     ~ComponentManager() = default;
 
     template <typename T> ComponentType getComponentType() {
-      TypeHash typeName = typeid(T).hash_code();
-
-      if (componentTypes.find(typeName) == componentTypes.end()) {
-        registerComponent<T>();
-      }
-
-      return componentTypes[typeName];
+      return componentTypeOf<T>();
     }
 
     template <typename T>
@@ -51,46 +47,51 @@ namespace keptech::ecs {
     }
 
     void onEntityDestroyed(EntityHandle entity) {
+      std::scoped_lock lock(registerMutex);
       for (auto& callback : deleteCallbacks) {
         callback(entity);
       }
     }
 
     template <typename T> ComponentArray<T>& all() {
-      TypeHash typeName = typeid(T).hash_code();
+      ComponentType type = componentTypeOf<T>();
 
-      if (componentArrays.find(typeName) == componentArrays.end()) {
-        return registerComponent<T>();
+      if (!registered[type].load(std::memory_order_acquire)) [[unlikely]] {
+        return registerComponent<T>(type);
       }
 
-      return *static_cast<ComponentArray<T>*>(componentArrays[typeName].get());
+      return *static_cast<ComponentArray<T>*>(componentArrays[type].get());
     }
 
-  private:
-    template <typename T> ComponentArray<T>& registerComponent() {
-      ECS_DEBUG("Registering component type: {}", typeid(T).name());
-
-      TypeHash typeName = typeid(T).hash_code();
-
-      assert(componentTypes.find(typeName) == componentTypes.end() &&
-             "Registering component type more than once.");
+    template <typename... Ts> View<Ts...> view(ThreadPool* pool = nullptr) {
+      return View<Ts...>(pool, all<std::remove_const_t<Ts>>()...);
+    }
 
-      componentTypes[typeName] = nextComponentTypeIndex++;
+  private:
+    /// Types are registered on first use, which may be from systems running
+    /// in parallel, so registration is serialised and published through
+    /// `registered`.
+    template <typename T>
+    ComponentArray<T>& registerComponent(ComponentType type) {
+      std::scoped_lock lock(registerMutex);
 
-      componentArrays[typeName] = std::make_unique<ComponentArray<T>>();
-      ComponentArray<T>& array =
-          *static_cast<ComponentArray<T>*>(componentArrays[typeName].get());
+      if (!componentArrays[type]) {
+        ECS_DEBUG("Registering component type: {}", typeid(T).name());
 
-      deleteCallbacks.push_back(array.getDeleteCallback());
+        auto array = std::make_unique<ComponentArray<T>>();
+        deleteCallbacks.push_back(array->getDeleteCallback());
+        componentArrays[type] = std::move(array);
+        registered[type].store(true, std::memory_order_release);
+      }
 
-      return array;
+      return *static_cast<ComponentArray<T>*>(componentArrays[type].get());
     }
 
-    std::unordered_map<TypeHash, ComponentType> componentTypes{};
-    std::unordered_map<TypeHash, std::unique_ptr<IComponentArray>>
-        componentArrays;
-    uint8_t nextComponentTypeIndex = 0;
+    std::array<std::unique_ptr<IComponentArray>, MAX_COMPONENTS>
+        componentArrays{};
+    std::array<std::atomic<bool>, MAX_COMPONENTS> registered{};
 
     std::vector<std::function<void(EntityHandle)>> deleteCallbacks{};
+    std::mutex registerMutex;
   };
 } // namespace keptech::ecs
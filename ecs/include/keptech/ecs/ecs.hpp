@@ -1,12 +1,26 @@
 #pragma once
 
 #include "base.hpp"
+#include "commandBuffer.hpp"
+#ifdef KEPTECH_ECS_ARCHETYPES
+#include "archetypeManager.hpp"
+#else
 #include "componentManager.hpp"
+#endif
 #include "entityManager.hpp"
 #include "systemManager.hpp"
+#include "threadPool.hpp"
 #include <memory>
 
 namespace keptech::ecs {
+#ifdef KEPTECH_ECS_ARCHETYPES
+  using ComponentStorage = ArchetypeManager;
+  template <typename... Ts> using ViewOf = ArchetypeView<Ts...>;
+#else
+  using ComponentStorage = ComponentManager;
+  template <typename... Ts> using ViewOf = View<Ts...>;
+#endif
+
   class ECS {
     explicit ECS() = default;
 
@@ -22,19 +36,12 @@ namespace keptech::ecs {
 
     /// Destroys the given entity and removes all its components.
     void destroyEntity(EntityHandle entity) {
-      entityManager->destroy(entity);
-      componentManager->onEntityDestroyed(entity);
-      systemManager->onEntityDestroyed(entity);
+      destroyEntity(entity, entityManager->at(entity).getSignature());
     }
 
-    bool hasEntity(EntityHandle entity) {
-      try {
-        entityManager->get(entity);
-        return true;
-      } catch (...) {
-        return false;
-      }
-    }
+    /// Checks that the handle refers to a live entity. Handles to destroyed
+    /// entities stay stale even after their slot is reused.
+    bool hasEntity(EntityHandle entity) { return entityManager->has(entity); }
 
     Entity* getEntity(EntityHandle entity) {
       return entityManager->get(entity);
@@ -43,28 +50,30 @@ namespace keptech::ecs {
     Entity& getEntityRef(EntityHandle entity) {
       return entityManager->at(entity);
     }
+
+    [[nodiscard]] size_t getEntityCount() const {
+      return entityManager->getEntityCount();
+    }
+
+    /// Sets how many entities may be alive at once, up to MAX_ENTITIES.
+    void setMaxEntities(size_t capacity) {
+      entityManager->setCapacity(capacity);
+    }
 #pragma endregion
 
 #pragma region Component Methods
     /// Adds a component of type T to the given entity.
     template <typename T>
     void addComponent(EntityHandle entity, T&& component) {
-      componentManager->add<T>(entity, std::forward<T>(component));
-
-      auto componentType = componentManager->getComponentType<T>();
-      auto& entitySig = entityManager->at(entity);
-      entityManager->at(entity).getSignature().set(componentType, true);
-      systemManager->onEntitySignatureChanged(entity, entitySig.getSignature());
+      Signature previous =
+          insertComponent<T>(entity, std::forward<T>(component));
+      notifySignatureChanged(entity, previous);
     }
 
     /// Removes the component of type T from the given entity.
     template <typename T> void removeComponent(EntityHandle entity) {
-      componentManager->remove<T>(entity);
-
-      auto componentType = componentManager->getComponentType<T>();
-      auto& entitySig = entityManager->at(entity);
-      entityManager->at(entity).getSignature().set(componentType, false);
-      systemManager->onEntitySignatureChanged(entity, entitySig.getSignature());
+      Signature previous = eraseComponent<T>(entity);
+      notifySignatureChanged(entity, previous);
     }
 
     /// Checks if the given entity has a component of type T.
@@ -84,9 +93,23 @@ namespace keptech::ecs {
       return componentManager->at<T>(entity);
     }
 
+#ifndef KEPTECH_ECS_ARCHETYPES
     template <typename T> ComponentArray<T>& getAllComponents() {
       return componentManager->all<T>();
     }
+#endif
+
+    /// Gets a view over every entity that has all of the given components.
+    /// Component types may be const qualified for read-only access.
+    template <typename... Ts> ViewOf<Ts...> view() {
+      return componentManager->view<Ts...>(&getThreadPool());
+    }
+
+    /// Gets a read-only view over every entity that has all of the given
+    /// components.
+    template <typename... Ts> ViewOf<const Ts...> constView() {
+      return view<const Ts...>();
+    }
 
     /// Gets the ComponentType for the component type T.
     template <typename T> ComponentType getComponentType() {
@@ -99,6 +122,25 @@ namespace keptech::ecs {
       (signature.set(getComponentType<Args>(), true), ...);
       return signature;
     }
+
+    /// Gets a SystemAccess that reads the const qualified component types and
+    /// writes the rest, e.g. `access<const Camera, Transform>()`.
+    template <typename... Ts> SystemAccess access() {
+      SystemAccess access;
+      ((std::is_const_v<Ts> ? access.reads : access.writes)
+           .set(getComponentType<std::remove_const_t<Ts>>(), true),
+       ...);
+      return access;
+    }
+#pragma endregion
+
+#pragma region Command Methods
+    /// Gets the shared command buffer, played back by `flushCommands`.
+    EntityCommandBuffer& commands() { return commandBuffer; }
+
+    /// Applies every structural change recorded in `commands()`. Must not be
+    /// called while iterating a view or running systems.
+    void flushCommands() { commandBuffer.playback(*this); }
 #pragma endregion
 
 #pragma region System Methods
@@ -123,33 +165,121 @@ namespace keptech::ecs {
       systemManager->setSignature<T>(signature);
     }
 
+    /// Declares the components the system of type T reads and writes, so it
+    /// can be scheduled alongside systems it does not conflict with. Systems
+    /// without a declared access run alone on the main thread.
+    template <typename T> void setSystemAccess(const SystemAccess& access) {
+      systemManager->setAccess<T>(access);
+    }
+
+    /// Per-system phase timings from the last frame, in registration order.
+    [[nodiscard]] const std::vector<SystemTiming>& getSystemTimings() const {
+      return systemManager->getTimings();
+    }
+
     inline void preUpdateAllSystems(const FrameData& frameData) {
-      systemManager->preUpdateAllSystems(frameData);
+      systemManager->preUpdateAllSystems(frameData, &getThreadPool());
     }
 
     inline void updateAllSystems(const FrameData& frameData) {
-      systemManager->updateAllSystems(frameData);
+      systemManager->updateAllSystems(frameData, &getThreadPool());
     }
 
     inline void postUpdateAllSystems(const FrameData& frameData) {
-      systemManager->postUpdateAllSystems(frameData);
+      systemManager->postUpdateAllSystems(frameData, &getThreadPool());
     }
 #pragma endregion
 
+    /// Gets the job pool shared by the system scheduler and parallel
+    /// iteration. Started on first use.
+    ThreadPool& getThreadPool() {
+      if (!threadPool) {
+        threadPool = std::make_unique<ThreadPool>();
+      }
+      return *threadPool;
+    }
+
+    /// Restarts the job pool with the given number of worker threads. Zero runs
+    /// every job on the thread that waits for it.
+    void setWorkerCount(size_t workerCount) {
+      threadPool = std::make_unique<ThreadPool>(workerCount);
+    }
+
     void destroy() {
+      commandBuffer.clear();
+      threadPool.reset();
       entityManager.reset();
       componentManager.reset();
       systemManager.reset();
     }
 
   private:
+    friend class EntityCommandBuffer;
+
+    /// Adds the component without updating system membership. Returns the
+    /// entity's previous signature.
+    template <typename T>
+    Signature insertComponent(EntityHandle entity, T&& component) {
+      componentManager->add<T>(entity, std::forward<T>(component));
+
+      auto componentType = componentManager->getComponentType<T>();
+      Signature& signature = entityManager->at(entity).getSignature();
+      Signature previous = signature;
+      signature.set(componentType, true);
+      return previous;
+    }
+
+    /// Removes the component without updating system membership. Returns the
+    /// entity's previous signature.
+    template <typename T> Signature eraseComponent(EntityHandle entity) {
+      componentManager->remove<T>(entity);
+
+      auto componentType = componentManager->getComponentType<T>();
+      Signature& signature = entityManager->at(entity).getSignature();
+      Signature previous = signature;
+      signature.set(componentType, false);
+      return previous;
+    }
+
+    /// Destroys the entity, removing it from the systems matching `membership`
+    /// rather than its current signature.
+    void destroyEntity(EntityHandle entity, const Signature& membership) {
+      systemManager->onEntityDestroyed(entity, membership);
+      componentManager->onEntityDestroyed(entity);
+      entityManager->destroy(entity);
+    }
+
+    void notifySignatureChanged(EntityHandle entity,
+                                const Signature& previous) {
+      const Signature& signature = entityManager->at(entity).getSignature();
+      systemManager->onEntitySignatureChanged(entity, previous ^ signature,
+                                              signature);
+    }
+
     static ECS singleton;
 
     std::unique_ptr<EntityManager> entityManager =
         std::make_unique<EntityManager>();
-    std::unique_ptr<ComponentManager> componentManager =
-        std::make_unique<ComponentManager>();
+    std::unique_ptr<ComponentStorage> componentManager =
+        std::make_unique<ComponentStorage>();
     std::unique_ptr<SystemManager> systemManager =
         std::make_unique<SystemManager>();
+    std::unique_ptr<ThreadPool> threadPool = nullptr;
+    EntityCommandBuffer commandBuffer;
   };
+
+  template <typename T>
+  void EntityCommandBuffer::AddCommand<T>::apply(Playback& playback) {
+    EntityHandle entity = playback.resolve(target);
+    Signature previous =
+        playback.ecs.insertComponent<T>(entity, std::move(component));
+    playback.changed.try_emplace(entity, previous);
+  }
+
+  template <typename T>
+  void EntityCommandBuffer::RemoveCommand<T>::apply(Playback& playback) {
+    EntityHandle entity = playback.resolve(target);
+    Signature previous = playback.ecs.eraseComponent<T>(entity);
+    playback.changed.try_emplace(entity, previous);
+  }
 } // namespace keptech::ecs
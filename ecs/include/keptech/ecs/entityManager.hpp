@@ -2,59 +2,106 @@
 
 #include "base.hpp"
 #include "entity.hpp"
+#include <array>
+#include <cassert>
+#include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 
 namespace keptech::ecs {
+  /// Owns every entity slot.
+  /// Slots are allocated in pages, so references to an Entity stay valid as
+  /// the manager grows. Freed slots are reused oldest first, with their
+  /// generation bumped so old handles to them read as stale.
   class EntityManager {
   public:
+    constexpr static size_t PAGE_SIZE = 1024;
+
+    explicit EntityManager(size_t maxEntities = MAX_ENTITIES)
+        : capacity(maxEntities) {
+      assert(capacity <= MAX_ENTITIES && "Entity capacity above MAX_ENTITIES.");
+    }
+
     Entity& create(const std::string& name) {
+      EntityIndex index = 0;
       if (!freedEntities.empty()) {
-        EntityHandle entity = freedEntities.front();
+        index = freedEntities.front();
         freedEntities.pop();
-        entities[entity] = Entity(entity, name);
-        return entities[entity];
       } else {
-        assert(nextEntity < MAX_ENTITIES && "Too many entities in existence.");
-        entities[nextEntity] = Entity(nextEntity, name);
-        nextEntity++;
-        return entities[nextEntity - 1];
+        assert(nextEntity < capacity && "Too many entities in existence.");
+        index = nextEntity++;
+        if (index / PAGE_SIZE >= pages.size()) {
+          pages.push_back(std::make_unique<Page>());
+        }
+        generations.push_back(0);
       }
+
+      Entity& entity = slot(index);
+      entity = Entity(makeEntityHandle(index, generations[index]), name);
+      return entity;
     }
 
     void destroy(EntityHandle entity) {
-      assert(entity < nextEntity && "Entity out of range.");
+      assert(has(entity) && "Destroying invalid or stale entity.");
 
-      entities[entity].onDestroy();
+      EntityIndex index = entityIndex(entity);
+      slot(index).onDestroy();
+      generations[index] = static_cast<EntityGeneration>(
+          (generations[index] + 1) & ENTITY_GENERATION_MASK);
 
-      freedEntities.push(entity);
+      freedEntities.push(index);
     }
 
     Entity& at(EntityHandle entity) {
-      assert(entity < nextEntity && "Entity out of range.");
-      return entities[entity];
+      assert(has(entity) && "Invalid or stale entity.");
+      return slot(entityIndex(entity));
     }
 
     Entity* get(EntityHandle entity) {
-      if (entity >= nextEntity || !entities[entity].isValid()) {
+      if (!has(entity)) {
         return nullptr;
       }
-      return &entities[entity];
+      return &slot(entityIndex(entity));
     }
 
-    [[nodiscard]] uint16_t getEntityCount() const {
-      return nextEntity - static_cast<uint16_t>(freedEntities.size());
+    [[nodiscard]] size_t getEntityCount() const {
+      return nextEntity - freedEntities.size();
     }
 
-    bool has(EntityHandle entity) {
-      if (entity >= nextEntity)
+    /// Checks that the handle refers to a live entity, and not an earlier
+    /// occupant of its slot.
+    [[nodiscard]] bool has(EntityHandle entity) const {
+      EntityIndex index = entityIndex(entity);
+      if (index >= nextEntity) {
         return false;
-      return entities[entity].isValid();
+      }
+      return slot(index).getHandle() == entity;
+    }
+
+    [[nodiscard]] size_t getCapacity() const { return capacity; }
+
+    /// Changes how many entity slots may be in use at once. Cannot shrink below
+    /// the slots already handed out.
+    void setCapacity(size_t newCapacity) {
+      assert(newCapacity <= MAX_ENTITIES &&
+             "Entity capacity above MAX_ENTITIES.");
+      assert(newCapacity >= nextEntity &&
+             "Entity capacity below slots in use.");
+      capacity = newCapacity;
     }
 
   private:
-    EntityHandle nextEntity = 0;
-    std::array<Entity, MAX_ENTITIES> entities{};
-    std::queue<EntityHandle> freedEntities{};
+    using Page = std::array<Entity, PAGE_SIZE>;
+
+    [[nodiscard]] Entity& slot(EntityIndex index) const {
+      return (*pages[index / PAGE_SIZE])[index % PAGE_SIZE];
+    }
+
+    size_t capacity;
+    EntityIndex nextEntity = 0;
+    std::vector<std::unique_ptr<Page>> pages{};
+    std::vector<EntityGeneration> generations{};
+    std::queue<EntityIndex> freedEntities{};
   };
 } // namespace keptech::ecs
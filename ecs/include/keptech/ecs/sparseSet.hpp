@@ -0,0 +1,136 @@
+#pragma once
+
+#include "base.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace keptech::ecs {
+  /// Packed set of entity handles.
+  /// Lookups go through a paged sparse array, so insert, erase and contains
+  /// are O(1) and memory only grows with the highest handle in use. The packed
+  /// side can be walked linearly and stays in the same order as any dense
+  /// arrays kept alongside it, as long as they mirror the swap-and-pop done by
+  /// `erase`.
+  ///
+  /// The sparse side is keyed on the entity index, and the packed side keeps
+  /// the full handle, so a stale handle to a reused slot is not found.
+  class SparseSet {
+  public:
+    using Index = uint32_t;
+
+    constexpr static size_t PAGE_SIZE = 1024;
+    constexpr static Index INVALID_INDEX = UINT32_MAX;
+
+    SparseSet() = default;
+    SparseSet(const SparseSet&) = delete;
+    SparseSet& operator=(const SparseSet&) = delete;
+    SparseSet(SparseSet&&) noexcept = default;
+    SparseSet& operator=(SparseSet&&) noexcept = default;
+    ~SparseSet() = default;
+
+    /// Adds the entity to the end of the packed array and returns its index.
+    Index insert(EntityHandle entity) {
+      assert(!contains(entity) && "Entity inserted into SparseSet twice.");
+
+      auto index = static_cast<Index>(packed.size());
+      packed.push_back(entity);
+      slot(entity) = index;
+      return index;
+    }
+
+    /// Removes the entity by moving the last packed entity into its place.
+    /// Returns the index that was overwritten.
+    Index erase(EntityHandle entity) {
+      Index index = indexOf(entity);
+      assert(index != INVALID_INDEX && "Erasing entity not in SparseSet.");
+
+      EntityHandle last = packed.back();
+      packed[index] = last;
+      slot(last) = index;
+
+      packed.pop_back();
+      slot(entity) = INVALID_INDEX;
+      return index;
+    }
+
+    [[nodiscard]] bool contains(EntityHandle entity) const {
+      return indexOf(entity) != INVALID_INDEX;
+    }
+
+    /// Returns the packed index of the entity, or INVALID_INDEX.
+    [[nodiscard]] Index indexOf(EntityHandle entity) const {
+      size_t page = entityIndex(entity) / PAGE_SIZE;
+      if (page >= pages.size() || !pages[page]) {
+        return INVALID_INDEX;
+      }
+
+      Index index = (*pages[page])[entityIndex(entity) % PAGE_SIZE];
+      if (index == INVALID_INDEX || packed[index] != entity) {
+        return INVALID_INDEX;
+      }
+      return index;
+    }
+
+    /// Sorts the packed entities, by handle unless a comparator is given.
+    /// Dense arrays kept alongside the set are not reordered.
+    template <typename Compare = std::less<>>
+    void sort(Compare compare = Compare{}) {
+      std::ranges::sort(packed, compare);
+      for (size_t i = 0; i < packed.size(); ++i) {
+        slot(packed[i]) = static_cast<Index>(i);
+      }
+    }
+
+    void clear() {
+      for (auto entity : packed) {
+        slot(entity) = INVALID_INDEX;
+      }
+      packed.clear();
+    }
+
+    void reserve(size_t count) { packed.reserve(count); }
+
+    [[nodiscard]] size_t size() const { return packed.size(); }
+    [[nodiscard]] bool empty() const { return packed.empty(); }
+
+    [[nodiscard]] EntityHandle operator[](size_t index) const {
+      return packed[index];
+    }
+
+    [[nodiscard]] std::span<const EntityHandle> entities() const {
+      return packed;
+    }
+
+    [[nodiscard]] const EntityHandle* data() const { return packed.data(); }
+
+    [[nodiscard]] std::vector<EntityHandle>::const_iterator begin() const {
+      return packed.cbegin();
+    }
+    [[nodiscard]] std::vector<EntityHandle>::const_iterator end() const {
+      return packed.cend();
+    }
+
+  private:
+    using Page = std::array<Index, PAGE_SIZE>;
+
+    Index& slot(EntityHandle entity) {
+      size_t page = entityIndex(entity) / PAGE_SIZE;
+      if (page >= pages.size()) {
+        pages.resize(page + 1);
+      }
+      if (!pages[page]) {
+        pages[page] = std::make_unique<Page>();
+        pages[page]->fill(INVALID_INDEX);
+      }
+      return (*pages[page])[entityIndex(entity) % PAGE_SIZE];
+    }
+
+    std::vector<std::unique_ptr<Page>> pages;
+    std::vector<EntityHandle> packed;
+  };
+} // namespace keptech::ecs
@@ -2,31 +2,42 @@
 
 #include "base.hpp"
 #include "frameData.hpp"
+#include "sparseSet.hpp"
 #include <functional>
-#include <set>
 
 namespace keptech::ecs {
   class SystemManager;
 
+  /// Component types a system reads and writes during its update phases.
+  /// Systems whose accesses do not conflict may run at the same time.
+  struct SystemAccess {
+    Signature reads;
+    Signature writes;
+
+    [[nodiscard]] bool conflictsWith(const SystemAccess& other) const {
+      return (writes & (other.reads | other.writes)).any() ||
+             (other.writes & reads).any();
+    }
+  };
+
   class System {
     friend class SystemManager;
 
   public:
     System() = default;
-    System(const System&) = default;
+    System(const System&) = delete;
     System(System&&) noexcept = default;
-    System& operator=(const System&) = default;
-    System& operator=(System&&) = default;
+    System& operator=(const System&) = delete;
+    System& operator=(System&&) noexcept = default;
 
     virtual void preUpdate(const FrameData& frameData) { (void)frameData; }
     virtual void onUpdate(const FrameData& frameData) { (void)frameData; }
     virtual void postUpdate(const FrameData& frameData) { (void)frameData; }
 
-    virtual void onEntityAdded(EntityHandle entity) { entities.insert(entity); }
-
-    virtual void onEntityRemoved(EntityHandle entity) {
-      entities.erase(entity);
-    }
+    /// Called after the entity joins `entities`.
+    virtual void onEntityAdded(EntityHandle entity) { (void)entity; }
+    /// Called after the entity leaves `entities`.
+    virtual void onEntityRemoved(EntityHandle entity) { (void)entity; }
 
     std::function<void(const FrameData&)> getPreUpdateFunction() {
       return [this](const FrameData& frameData) { this->preUpdate(frameData); };
@@ -49,6 +60,14 @@ namespace keptech::ecs {
     virtual ~System() = default;
 
   protected:
-    std::set<EntityHandle> entities;
+    /// Entities matching the system's signature, kept by the SystemManager.
+    /// Stored packed, so iteration is a linear walk. Order is arbitrary unless
+    /// `sortEntities` is set, in which case the set is sorted by handle before
+    /// each preUpdate it changed.
+    SparseSet entities;
+    bool sortEntities = false;
+
+  private:
+    bool entitiesUnsorted = false;
   };
 } // namespace keptech::ecs
@@ -1,24 +1,48 @@
 #pragma once
 
 #include "system.hpp"
+#include "typeIndex.hpp"
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <optional>
+#include <string>
 
 namespace keptech::ecs {
+  class ThreadPool;
+
+  /// Time spent in each phase of a system during the last frame.
+  struct SystemTiming {
+    std::string name;
+    float preUpdateMs = 0;
+    float updateMs = 0;
+    float postUpdateMs = 0;
+  };
+
+  /// Registers systems and runs their update phases.
+  /// Each phase is scheduled as a dependency graph over the declared accesses
+  /// of the systems: a system waits for every earlier-registered system it
+  /// conflicts with, and otherwise runs on the thread pool alongside the
+  /// others. Systems with no declared access run alone on the calling thread,
+  /// in registration order.
   class SystemManager {
-    using TypeHash = size_t;
+    constexpr static size_t NO_SYSTEM = SIZE_MAX;
 
   public:
     template <typename T, typename... Args>
     T& registerSystem(Signature signature, Args&&... args) {
-      TypeHash typeName = typeid(T).hash_code();
+      size_t typeIndex = TypeIndex<SystemFamily>::of<T>();
+      if (typeIndex >= systemIndices.size()) {
+        systemIndices.resize(typeIndex + 1, NO_SYSTEM);
+      }
 
-      assert(systemIndices.find(typeName) == systemIndices.end() &&
+      assert(systemIndices[typeIndex] == NO_SYSTEM &&
              "Registering system more than once.");
 
       size_t index = systems.size();
 
-      systemIndices[typeName] = index;
+      systemIndices[typeIndex] = index;
 
       auto system = std::make_unique<T>(std::forward<Args>(args)...);
       preUpdateFunctions.push_back(system->getPreUpdateFunction());
@@ -28,78 +52,124 @@ namespace keptech::ecs {
       onEntityRemovedFunctions.push_back(system->getOnEntityRemovedFunction());
       systems.push_back(std::move(system));
       signatures.push_back(signature);
+      indexSystem(index);
+      accesses.emplace_back(std::nullopt);
+      timings.push_back(SystemTiming{.name = typeid(T).name()});
+      scheduleDirty = true;
       ecs::System& sys = *systems[index].get();
       return static_cast<T&>(sys);
     }
 
-    template <typename T> bool has() {
-      TypeHash typeName = typeid(T).hash_code();
-      return systemIndices.find(typeName) != systemIndices.end();
-    }
+    template <typename T> bool has() { return indexOf<T>() != NO_SYSTEM; }
 
     template <typename T> T& get() {
-      TypeHash typeName = typeid(T).hash_code();
-
-      auto found = systemIndices.find(typeName);
+      size_t index = indexOf<T>();
 
-      assert(found != systemIndices.end() && "System used before registered.");
+      assert(index != NO_SYSTEM && "System used before registered.");
 
-      return *static_cast<T*>(systems[found->second].get());
+      return *static_cast<T*>(systems[index].get());
     }
 
     template <typename T> void setSignature(Signature signature) {
-      TypeHash typeName = typeid(T).hash_code();
+      size_t index = indexOf<T>();
 
-      auto found = systemIndices.find(typeName);
+      assert(index != NO_SYSTEM && "System used before registered.");
 
-      assert(found != systemIndices.end() && "System used before registered.");
+      signatures[index] = signature;
+      rebuildComponentIndex();
+    }
+
+    /// Declares the components the system of type T touches in its update
+    /// phases, letting it run in parallel with non-conflicting systems.
+    template <typename T> void setAccess(const SystemAccess& access) {
+      size_t index = indexOf<T>();
+
+      assert(index != NO_SYSTEM && "System used before registered.");
 
-      signatures[found->second] = signature;
+      accesses[index] = access;
+      scheduleDirty = true;
     }
 
-    void onEntityDestroyed(EntityHandle entity) {
-      for (auto& system : systems) {
-        system->entities.erase(entity);
-      }
+    [[nodiscard]] const std::vector<SystemTiming>& getTimings() const {
+      return timings;
     }
 
-    void onEntitySignatureChanged(EntityHandle entity,
-                                  const Signature& entitySignature) {
-      for (size_t i = 0; i < systems.size(); ++i) {
-        auto& system = systems[i];
-        const auto& systemSignature = signatures[i];
-
-        if ((entitySignature & systemSignature) == systemSignature) {
-          system->entities.insert(entity);
-          onEntityAddedFunctions[i](entity);
-        } else {
-          system->entities.erase(entity);
-          onEntityRemovedFunctions[i](entity);
-        }
-      }
+    /// Removes the entity from every system it belongs to, given its last
+    /// signature.
+    void onEntityDestroyed(EntityHandle entity, const Signature& signature);
+
+    /// Updates system membership after the components in `changed` were added
+    /// to or removed from the entity, leaving it with `signature`. Only systems
+    /// that require one of the changed components are checked, and callbacks
+    /// only fire when membership actually changes.
+    ///
+    /// Systems with an empty signature never gain entities.
+    void onEntitySignatureChanged(EntityHandle entity, const Signature& changed,
+                                  const Signature& signature);
+
+    inline void preUpdateAllSystems(const FrameData& frameData,
+                                    ThreadPool* pool = nullptr) {
+      runPhase(Phase::PreUpdate, frameData, pool);
     }
 
-    inline void preUpdateAllSystems(const FrameData& frameData) {
-      for (auto& f : preUpdateFunctions) {
-        f(frameData);
-      }
+    inline void updateAllSystems(const FrameData& frameData,
+                                 ThreadPool* pool = nullptr) {
+      runPhase(Phase::Update, frameData, pool);
     }
 
-    inline void updateAllSystems(const FrameData& frameData) {
-      for (auto& f : updateFunctions) {
-        f(frameData);
-      }
+    inline void postUpdateAllSystems(const FrameData& frameData,
+                                     ThreadPool* pool = nullptr) {
+      runPhase(Phase::PostUpdate, frameData, pool);
+    }
+
+  private:
+    enum class Phase : uint8_t { PreUpdate, Update, PostUpdate };
+
+    /// A run of systems between two exclusive ones. `dependents` and
+    /// `dependencyCounts` are indexed by position within the segment.
+    struct Segment {
+      bool exclusive = false;
+      std::vector<size_t> systems;
+      std::vector<std::vector<size_t>> dependents;
+      std::vector<uint32_t> dependencyCounts;
+    };
+
+    /// Registration index of the system of type T, or NO_SYSTEM.
+    template <typename T> [[nodiscard]] size_t indexOf() const {
+      size_t typeIndex = TypeIndex<SystemFamily>::of<T>();
+      return typeIndex < systemIndices.size() ? systemIndices[typeIndex]
+                                              : NO_SYSTEM;
     }
 
-    inline void postUpdateAllSystems(const FrameData& frameData) {
-      for (auto& f : postUpdateFunctions) {
-        f(frameData);
+    void indexSystem(size_t system);
+    void rebuildComponentIndex();
+
+    /// Calls `fn(system)` once for each system requiring any component in
+    /// `components`.
+    template <typename Fn>
+    void forEachAffectedSystem(const Signature& components, Fn&& fn) {
+      ++visitStamp;
+      for (size_t type = 0; type < MAX_COMPONENTS; ++type) {
+        if (!components.test(type)) {
+          continue;
+        }
+        for (size_t system : systemsByComponent[type]) {
+          if (visited[system] != visitStamp) {
+            visited[system] = visitStamp;
+            fn(system);
+          }
+        }
       }
     }
 
-  private:
-    std::unordered_map<TypeHash, size_t>
-        systemIndices{}; // Map from system type to index in systems vector
+    void buildSchedule();
+    void runPhase(Phase phase, const FrameData& frameData, ThreadPool* pool);
+    void runSystem(Phase phase, size_t system, const FrameData& frameData);
+    void runSegment(const Segment& segment, Phase phase,
+                    const FrameData& frameData, ThreadPool& pool);
+
+    std::vector<size_t>
+        systemIndices{}; // Map from system type index to index in systems
     std::vector<std::unique_ptr<System>> systems{};
     std::vector<std::function<void(const FrameData&)>> preUpdateFunctions{};
     std::vector<std::function<void(const FrameData&)>> updateFunctions{};
@@ -107,5 +177,13 @@ namespace keptech::ecs {
     std::vector<std::function<void(EntityHandle)>> onEntityAddedFunctions{};
     std::vector<std::function<void(EntityHandle)>> onEntityRemovedFunctions{};
     std::vector<Signature> signatures{};
+    std::array<std::vector<size_t>, MAX_COMPONENTS> systemsByComponent{};
+    std::vector<uint64_t> visited{};
+    uint64_t visitStamp = 0;
+    std::vector<std::optional<SystemAccess>> accesses{};
+    std::vector<SystemTiming> timings{};
+
+    std::vector<Segment> schedule{};
+    bool scheduleDirty = false;
   };
 } // namespace keptech::ecs
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace keptech::ecs {
+  /// Counts the jobs of a group that have not finished yet.
+  struct JobGroup {
+    std::atomic<size_t> pending = 0;
+
+    [[nodiscard]] bool done() const {
+      return pending.load(std::memory_order_acquire) == 0;
+    }
+  };
+
+  /// Work-stealing job pool.
+  /// Each worker owns a queue, pushing and popping at the back, while idle
+  /// workers steal from the front of the others. Jobs submitted from outside
+  /// the pool go to a shared queue that every worker steals from.
+  ///
+  /// Waiting on a group runs queued jobs on the waiting thread until the
+  /// group is done, so jobs may submit and wait on other jobs.
+  class ThreadPool {
+  public:
+    using Job = std::function<void()>;
+
+    /// Defaults to one worker per hardware thread, minus the calling thread.
+    explicit ThreadPool(size_t workerCount = defaultWorkerCount());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+    ~ThreadPool();
+
+    void submit(Job job, JobGroup& group);
+
+    /// Blocks until every job in the group has finished, helping out in the
+    /// meantime.
+    void wait(JobGroup& group);
+
+    [[nodiscard]] size_t getWorkerCount() const { return workers.size(); }
+
+    /// Number of threads that can run jobs at once, including the waiter.
+    [[nodiscard]] size_t getConcurrency() const { return workers.size() + 1; }
+
+    /// Index of the calling thread, below `getConcurrency()`, for picking
+    /// per-thread scratch space inside jobs. Every thread outside the pool
+    /// shares the last index.
+    [[nodiscard]] size_t threadIndex() const { return currentQueue(); }
+
+    static size_t defaultWorkerCount();
+
+  private:
+    struct Task {
+      Job job;
+      JobGroup* group;
+    };
+
+    struct Queue {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+
+    /// Runs one job, preferring the back of `home` and then stealing from the
+    /// front of the other queues. Returns false if every queue was empty.
+    bool runOne(size_t home);
+
+    [[nodiscard]] size_t currentQueue() const;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued = 0;
+    bool stopping = false;
+  };
+} // namespace keptech::ecs
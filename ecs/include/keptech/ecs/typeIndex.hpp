@@ -0,0 +1,51 @@
+#pragma once
+
+#include "base.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace keptech::ecs {
+  /// Dense, process-wide indices for types, counted separately per `Family`.
+  /// Each type's index is an inline static member initialised when the
+  /// program loads, so a lookup is a plain load with no initialisation guard.
+  /// Since that initialisation is unordered, indices must not be asked for
+  /// from other static initialisers.
+  ///
+  /// The members have vague linkage and are merged by the linker, so every
+  /// static library linked into the executable sees the same index for a
+  /// type. Types used across a shared library boundary would each get their
+  /// own index.
+  template <typename Family> class TypeIndex {
+  public:
+    template <typename T> static size_t of() {
+      return index<std::remove_cvref_t<T>>;
+    }
+
+    /// Number of indices handed out so far.
+    static size_t count() { return counter().load(std::memory_order_relaxed); }
+
+  private:
+    static std::atomic<size_t>& counter() {
+      static std::atomic<size_t> value = 0;
+      return value;
+    }
+
+    static size_t next() {
+      return counter().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename T> inline static const size_t index = next();
+  };
+
+  struct ComponentFamily;
+  struct SystemFamily;
+
+  /// Signature bit of the component type T, shared by every ECS instance.
+  template <typename T> ComponentType componentTypeOf() {
+    size_t index = TypeIndex<ComponentFamily>::of<T>();
+    assert(index < MAX_COMPONENTS && "Too many component types.");
+    return static_cast<ComponentType>(index);
+  }
+} // namespace keptech::ecs
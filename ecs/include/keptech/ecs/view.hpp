@@ -0,0 +1,186 @@
+#pragma once
+
+#include "base.hpp"
+#include "componentArray.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace keptech::ecs {
+  /// Iterates every entity that owns all of `Ts`.
+  /// Iteration is driven by the smallest of the component pools, and the
+  /// components are fetched by packed index, so there is no per-entity map
+  /// lookup. A `const` component type is handed out as a const reference.
+  ///
+  /// Adding or removing any of the viewed components while iterating
+  /// invalidates the view.
+  template <typename... Ts> class View {
+    static_assert(sizeof...(Ts) > 0, "A view needs at least one component.");
+
+    template <typename T> using Array = ComponentArray<std::remove_const_t<T>>;
+
+  public:
+    using Item = std::tuple<EntityHandle, Ts&...>;
+    using Indices = std::array<SparseSet::Index, sizeof...(Ts)>;
+
+    explicit View(Array<Ts>&... viewed) : View(nullptr, viewed...) {}
+
+    View(ThreadPool* jobPool, Array<Ts>&... viewed)
+        : arrays(&viewed...), pool(jobPool) {
+      std::array<const SparseSet*, sizeof...(Ts)> sets = {
+          &viewed.getEntitySet()...};
+      for (size_t i = 1; i < sets.size(); ++i) {
+        if (sets[i]->size() < sets[driverSlot]->size()) {
+          driverSlot = i;
+        }
+      }
+      driver = sets[driverSlot];
+    }
+
+    /// Calls `fn(entity, components...)` or `fn(components...)` for every
+    /// matching entity.
+    template <typename Fn> void each(Fn&& fn) const {
+      const size_t count = driver->size();
+      for (size_t i = 0; i < count; ++i) {
+        visit(i, fn);
+      }
+    }
+
+    /// Like `each`, but splits the packed range into batches of `grainSize`
+    /// entities and runs them on the thread pool, returning once all are done.
+    /// `fn` is called concurrently, so it must only write to the components it
+    /// is given or to per-thread state, see `ThreadPool::threadIndex`.
+    template <typename Fn>
+    void parallelForEach(Fn&& fn, size_t grainSize = 256) const {
+      const size_t count = driver->size();
+      if (!pool || count <= grainSize) {
+        each(fn);
+        return;
+      }
+
+      JobGroup group;
+      for (size_t begin = 0; begin < count; begin += grainSize) {
+        size_t end = std::min(begin + grainSize, count);
+        pool->submit(
+            [this, &fn, begin, end] {
+              for (size_t i = begin; i < end; ++i) {
+                visit(i, fn);
+              }
+            },
+            group);
+      }
+      pool->wait(group);
+    }
+
+    class Iterator {
+    public:
+      using difference_type = std::ptrdiff_t;
+      using value_type = Item;
+
+      Iterator() = default;
+      Iterator(const View* owner, size_t start)
+          : view(owner), position(start) {
+        skip();
+      }
+
+      Item operator*() const {
+        return view->fetch((*view->driver)[position], indices,
+                           std::index_sequence_for<Ts...>{});
+      }
+
+      Iterator& operator++() {
+        ++position;
+        skip();
+        return *this;
+      }
+
+      Iterator operator++(int) {
+        Iterator copy = *this;
+        ++*this;
+        return copy;
+      }
+
+      bool operator==(const Iterator& other) const {
+        return position == other.position;
+      }
+
+    private:
+      /// Advances to the next entity every pool holds, keeping its indices.
+      void skip() {
+        while (position < view->driver->size() &&
+               !view->lookup(position, indices)) {
+          ++position;
+        }
+      }
+
+      const View* view = nullptr;
+      size_t position = 0;
+      Indices indices = {};
+    };
+
+    [[nodiscard]] Iterator begin() const { return Iterator(this, 0); }
+    [[nodiscard]] Iterator end() const {
+      return Iterator(this, driver->size());
+    }
+
+    /// Upper bound on the number of entities the view will visit.
+    [[nodiscard]] size_t sizeHint() const { return driver->size(); }
+
+    [[nodiscard]] bool contains(EntityHandle entity) const {
+      return (std::get<Array<Ts>*>(arrays)->has(entity) && ...);
+    }
+
+  private:
+    template <typename Fn> void visit(size_t position, Fn& fn) const {
+      Indices indices;
+      if (lookup(position, indices)) {
+        invoke(fn, (*driver)[position], indices,
+               std::index_sequence_for<Ts...>{});
+      }
+    }
+
+    /// Fills the packed index of the driver's `position`th entity in every
+    /// pool, returning false as soon as one lacks it. The driver's own index
+    /// is `position`, so only the other pools are looked up.
+    bool lookup(size_t position, Indices& indices) const {
+      return lookup(position, (*driver)[position], indices,
+                    std::index_sequence_for<Ts...>{});
+    }
+
+    template <size_t... Is>
+    bool lookup(size_t position, EntityHandle entity, Indices& indices,
+                std::index_sequence<Is...> /*unused*/) const {
+      return ((indices[Is] = Is == driverSlot
+                                 ? static_cast<SparseSet::Index>(position)
+                                 : std::get<Is>(arrays)->getEntitySet().indexOf(
+                                       entity),
+               indices[Is] != SparseSet::INVALID_INDEX) &&
+              ...);
+    }
+
+    template <typename Fn, size_t... Is>
+    void invoke(Fn& fn, EntityHandle entity, const Indices& indices,
+                std::index_sequence<Is...> /*unused*/) const {
+      if constexpr (std::is_invocable_v<Fn&, EntityHandle, Ts&...>) {
+        fn(entity, std::get<Is>(arrays)->atIndex(indices[Is])...);
+      } else {
+        fn(std::get<Is>(arrays)->atIndex(indices[Is])...);
+      }
+    }
+
+    template <size_t... Is>
+    Item fetch(EntityHandle entity, const Indices& indices,
+               std::index_sequence<Is...> /*unused*/) const {
+      return Item{entity, std::get<Is>(arrays)->atIndex(indices[Is])...};
+    }
+
+    std::tuple<Array<Ts>*...> arrays;
+    /// Smallest of the pools, and its position in `Ts`.
+    const SparseSet* driver = nullptr;
+    size_t driverSlot = 0;
+    ThreadPool* pool = nullptr;
+  };
+} // namespace keptech::ecs
@@ -0,0 +1,192 @@
+#include "keptech/ecs/archetype.hpp"
+#include "keptech/ecs/archetypeManager.hpp"
+
+#include <cassert>
+
+namespace keptech::ecs {
+  namespace {
+    constexpr size_t alignUp(size_t value, size_t alignment) {
+      return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    size_t layoutSize(std::vector<Archetype::Column>& columns,
+                      size_t capacity) {
+      size_t offset = sizeof(EntityHandle) * capacity;
+      for (auto& column : columns) {
+        offset = alignUp(offset, column.info.alignment);
+        column.offset = offset;
+        offset += column.info.size * capacity;
+      }
+      return offset;
+    }
+  } // namespace
+
+  Archetype::Archetype(const Signature& archetypeSignature,
+                       const std::array<ComponentInfo, MAX_COMPONENTS>& infos)
+      : signature(archetypeSignature) {
+    columnLookup.fill(NO_COLUMN);
+
+    size_t rowSize = sizeof(EntityHandle);
+    for (size_t type = 0; type < MAX_COMPONENTS; ++type) {
+      if (!signature.test(type)) {
+        continue;
+      }
+      assert(infos[type].size != 0 && "Component type was never registered.");
+      assert(infos[type].alignment <= CHUNK_ALIGNMENT &&
+             "Component alignment exceeds chunk alignment.");
+
+      columnLookup[type] = static_cast<uint8_t>(columns.size());
+      columns.push_back(Column{
+          .type = static_cast<ComponentType>(type),
+          .info = infos[type],
+          .offset = 0,
+      });
+      rowSize += infos[type].size;
+    }
+
+    capacity = CHUNK_SIZE / rowSize;
+    while (capacity > 1 && layoutSize(columns, capacity) > CHUNK_SIZE) {
+      --capacity;
+    }
+    assert(layoutSize(columns, capacity) <= CHUNK_SIZE &&
+           "Archetype row does not fit in a chunk.");
+  }
+
+  Archetype::~Archetype() {
+    for (auto& chunk : chunks) {
+      for (uint32_t i = 0; i < chunk.count; ++i) {
+        for (auto& column : columns) {
+          column.info.destroy(chunk.data + column.offset +
+                              (column.info.size * i));
+        }
+      }
+      ::operator delete(chunk.data, std::align_val_t{CHUNK_ALIGNMENT});
+    }
+  }
+
+  Archetype::Row Archetype::allocate(EntityHandle entity) {
+    if (chunks.empty() || chunks.back().count == capacity) {
+      chunks.push_back(Chunk{
+          .data = static_cast<std::byte*>(
+              ::operator new(CHUNK_SIZE, std::align_val_t{CHUNK_ALIGNMENT})),
+          .count = 0,
+      });
+    }
+
+    auto chunkIndex = static_cast<uint32_t>(chunks.size() - 1);
+    auto& chunk = chunks.back();
+    Row row{.chunk = chunkIndex, .index = chunk.count++};
+    entities(chunkIndex)[row.index] = entity;
+    ++rowCount;
+    return row;
+  }
+
+  EntityHandle Archetype::removeRow(Row row) {
+    auto lastChunk = static_cast<uint32_t>(chunks.size() - 1);
+    Row last{.chunk = lastChunk, .index = chunks.back().count - 1};
+
+    EntityHandle moved = INVALID_ENTITY_HANDLE;
+    if (row.chunk != last.chunk || row.index != last.index) {
+      for (uint8_t c = 0; c < columns.size(); ++c) {
+        columns[c].info.relocate(component(c, row), component(c, last));
+      }
+      moved = entities(last.chunk)[last.index];
+      entities(row.chunk)[row.index] = moved;
+    }
+
+    --rowCount;
+    if (--chunks.back().count == 0) {
+      ::operator delete(chunks.back().data, std::align_val_t{CHUNK_ALIGNMENT});
+      chunks.pop_back();
+    }
+
+    return moved;
+  }
+
+  Archetype* ArchetypeManager::archetypeFor(const Signature& signature) {
+    if (signature.none()) {
+      return nullptr;
+    }
+
+    auto found = archetypes.find(signature);
+    if (found != archetypes.end()) {
+      return found->second.get();
+    }
+
+    auto archetype = std::make_unique<Archetype>(signature, componentInfos);
+    Archetype* ptr = archetype.get();
+    archetypes.emplace(signature, std::move(archetype));
+    archetypeList.push_back(ptr);
+
+    ECS_DEBUG("Created archetype {} with {} rows per chunk",
+              signature.to_string(), ptr->getCapacity());
+    return ptr;
+  }
+
+  Archetype* ArchetypeManager::withComponent(Archetype* from,
+                                             ComponentType type) {
+    if (!from) {
+      Signature signature;
+      signature.set(type);
+      return archetypeFor(signature);
+    }
+
+    Archetype*& edge = from->addEdge(type);
+    if (!edge) {
+      edge = archetypeFor(Signature(from->getSignature()).set(type));
+    }
+    return edge;
+  }
+
+  Archetype* ArchetypeManager::withoutComponent(Archetype* from,
+                                                ComponentType type) {
+    assert(from && "Removing a component from an entity with none.");
+
+    Archetype*& edge = from->removeEdge(type);
+    if (!edge) {
+      edge = archetypeFor(Signature(from->getSignature()).reset(type));
+    }
+    return edge;
+  }
+
+  Archetype::Row ArchetypeManager::moveEntity(EntityHandle entity,
+                                              Archetype* target) {
+    Location& loc = location(entity);
+
+    Archetype::Row newRow{};
+    if (target) {
+      newRow = target->allocate(entity);
+    }
+
+    if (loc.archetype) {
+      Archetype& source = *loc.archetype;
+      auto columns = source.getColumns();
+      for (uint8_t c = 0; c < columns.size(); ++c) {
+        void* from = source.component(c, loc.row);
+        uint8_t dst = target ? target->columnOf(columns[c].type)
+                             : Archetype::NO_COLUMN;
+        if (dst != Archetype::NO_COLUMN) {
+          columns[c].info.relocate(target->component(dst, newRow), from);
+        } else {
+          columns[c].info.destroy(from);
+        }
+      }
+
+      EntityHandle moved = source.removeRow(loc.row);
+      if (moved != INVALID_ENTITY_HANDLE) {
+        locations[entityIndex(moved)].row = loc.row;
+      }
+    }
+
+    loc.archetype = target;
+    loc.row = newRow;
+    return newRow;
+  }
+
+  void ArchetypeManager::onEntityDestroyed(EntityHandle entity) {
+    if (!find(entity)) {
+      return;
+    }
+    moveEntity(entity, nullptr);
+  }
+} // namespace keptech::ecs
@@ -0,0 +1,45 @@
+#include "keptech/ecs/commandBuffer.hpp"
+#include "keptech/ecs/ecs.hpp"
+
+namespace keptech::ecs {
+  void EntityCommandBuffer::CreateCommand::apply(Playback& playback) {
+    playback.created.push_back(playback.ecs.createEntity(name).getHandle());
+  }
+
+  void EntityCommandBuffer::DestroyCommand::apply(Playback& playback) {
+    EntityHandle entity = playback.resolve(target);
+
+    // Systems have not been told about changes made earlier in this
+    // playback, so the entity leaves the systems it matched before playback.
+    // One created in this playback matched nothing, so no system hears of it.
+    auto changed = playback.changed.find(entity);
+    if (changed != playback.changed.end()) {
+      playback.ecs.destroyEntity(entity, changed->second);
+      playback.changed.erase(changed);
+    } else {
+      playback.ecs.destroyEntity(entity);
+    }
+  }
+
+  void EntityCommandBuffer::playback(ECS& ecs) {
+    std::vector<std::unique_ptr<Command>> recorded;
+    {
+      std::scoped_lock lock(mutex);
+      recorded.swap(commands);
+      pendingCount = 0;
+    }
+
+    if (recorded.empty()) {
+      return;
+    }
+
+    Playback state{.ecs = ecs, .created = {}, .changed = {}};
+    for (auto& command : recorded) {
+      command->apply(state);
+    }
+
+    for (const auto& [entity, previous] : state.changed) {
+      ecs.notifySignatureChanged(entity, previous);
+    }
+  }
+} // namespace keptech::ecs
@@ -0,0 +1,183 @@
+#include "keptech/ecs/systemManager.hpp"
+#include "keptech/ecs/threadPool.hpp"
+
+#include <chrono>
+
+namespace keptech::ecs {
+  void SystemManager::indexSystem(size_t system) {
+    for (size_t type = 0; type < MAX_COMPONENTS; ++type) {
+      if (signatures[system].test(type)) {
+        systemsByComponent[type].push_back(system);
+      }
+    }
+    visited.resize(systems.size(), 0);
+  }
+
+  void SystemManager::rebuildComponentIndex() {
+    for (auto& list : systemsByComponent) {
+      list.clear();
+    }
+    for (size_t i = 0; i < systems.size(); ++i) {
+      indexSystem(i);
+    }
+  }
+
+  void SystemManager::onEntityDestroyed(EntityHandle entity,
+                                        const Signature& signature) {
+    forEachAffectedSystem(signature, [&](size_t i) {
+      auto& system = systems[i];
+      if (system->entities.contains(entity)) {
+        system->entities.erase(entity);
+        system->entitiesUnsorted = true;
+        onEntityRemovedFunctions[i](entity);
+      }
+    });
+  }
+
+  void SystemManager::onEntitySignatureChanged(EntityHandle entity,
+                                               const Signature& changed,
+                                               const Signature& signature) {
+    forEachAffectedSystem(changed, [&](size_t i) {
+      auto& system = systems[i];
+      bool matches = (signature & signatures[i]) == signatures[i];
+      bool member = system->entities.contains(entity);
+
+      if (matches && !member) {
+        system->entities.insert(entity);
+        system->entitiesUnsorted = true;
+        onEntityAddedFunctions[i](entity);
+      } else if (!matches && member) {
+        system->entities.erase(entity);
+        system->entitiesUnsorted = true;
+        onEntityRemovedFunctions[i](entity);
+      }
+    });
+  }
+
+  void SystemManager::buildSchedule() {
+    schedule.clear();
+
+    for (size_t i = 0; i < systems.size(); ++i) {
+      bool exclusive = !accesses[i].has_value();
+      if (exclusive || schedule.empty() || schedule.back().exclusive) {
+        schedule.emplace_back();
+        schedule.back().exclusive = exclusive;
+      }
+
+      Segment& segment = schedule.back();
+      size_t node = segment.systems.size();
+      segment.systems.push_back(i);
+      segment.dependents.emplace_back();
+      segment.dependencyCounts.push_back(0);
+
+      if (exclusive) {
+        continue;
+      }
+
+      for (size_t earlier = 0; earlier < node; ++earlier) {
+        if (accesses[segment.systems[earlier]]->conflictsWith(*accesses[i])) {
+          segment.dependents[earlier].push_back(node);
+          ++segment.dependencyCounts[node];
+        }
+      }
+    }
+
+    scheduleDirty = false;
+  }
+
+  void SystemManager::runSystem(Phase phase, size_t system,
+                                const FrameData& frameData) {
+    auto start = std::chrono::steady_clock::now();
+
+    switch (phase) {
+    case Phase::PreUpdate:
+      preUpdateFunctions[system](frameData);
+      break;
+    case Phase::Update:
+      updateFunctions[system](frameData);
+      break;
+    case Phase::PostUpdate:
+      postUpdateFunctions[system](frameData);
+      break;
+    }
+
+    float ms = std::chrono::duration<float, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+    auto& timing = timings[system];
+    switch (phase) {
+    case Phase::PreUpdate:
+      timing.preUpdateMs = ms;
+      break;
+    case Phase::Update:
+      timing.updateMs = ms;
+      break;
+    case Phase::PostUpdate:
+      timing.postUpdateMs = ms;
+      break;
+    }
+  }
+
+  void SystemManager::runSegment(const Segment& segment, Phase phase,
+                                 const FrameData& frameData, ThreadPool& pool) {
+    std::vector<std::atomic<uint32_t>> remaining(segment.systems.size());
+    for (size_t i = 0; i < remaining.size(); ++i) {
+      remaining[i].store(segment.dependencyCounts[i],
+                         std::memory_order_relaxed);
+    }
+
+    JobGroup group;
+    std::function<void(size_t)> run = [&](size_t node) {
+      runSystem(phase, segment.systems[node], frameData);
+
+      for (size_t dependent : segment.dependents[node]) {
+        if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) ==
+            1) {
+          pool.submit([&run, dependent] { run(dependent); }, group);
+        }
+      }
+    };
+
+    for (size_t node = 0; node < segment.systems.size(); ++node) {
+      if (segment.dependencyCounts[node] == 0) {
+        pool.submit([&run, node] { run(node); }, group);
+      }
+    }
+
+    pool.wait(group);
+  }
+
+  void SystemManager::runPhase(Phase phase, const FrameData& frameData,
+                               ThreadPool* pool) {
+    if (phase == Phase::PreUpdate) {
+      for (auto& system : systems) {
+        if (system->sortEntities && system->entitiesUnsorted) {
+          system->entities.sort();
+          system->entitiesUnsorted = false;
+        }
+      }
+    }
+
+    if (!pool) {
+      for (size_t i = 0; i < systems.size(); ++i) {
+        runSystem(phase, i, frameData);
+      }
+      return;
+    }
+
+    if (scheduleDirty) {
+      buildSchedule();
+    }
+
+    for (const auto& segment : schedule) {
+      if (segment.exclusive || segment.systems.size() == 1) {
+        for (size_t system : segment.systems) {
+          runSystem(phase, system, frameData);
+        }
+      } else {
+        runSegment(segment, phase, frameData, *pool);
+      }
+    }
+  }
+} // namespace keptech::ecs
@@ -0,0 +1,120 @@
+#include "keptech/ecs/threadPool.hpp"
+
+namespace keptech::ecs {
+  namespace {
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentIndex = 0;
+  } // namespace
+
+  size_t ThreadPool::defaultWorkerCount() {
+    size_t hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 0;
+  }
+
+  ThreadPool::ThreadPool(size_t workerCount) {
+    // The last queue is shared by every thread outside the pool.
+    queues.reserve(workerCount + 1);
+    for (size_t i = 0; i < workerCount + 1; ++i) {
+      queues.push_back(std::make_unique<Queue>());
+    }
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+      workers.emplace_back([this, i] { workerLoop(i); });
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      std::scoped_lock lock(sleepMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  size_t ThreadPool::currentQueue() const {
+    return currentPool == this ? currentIndex : queues.size() - 1;
+  }
+
+  void ThreadPool::submit(Job job, JobGroup& group) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+      Queue& queue = *queues[currentQueue()];
+      std::scoped_lock lock(queue.mutex);
+      queue.tasks.push_back(Task{.job = std::move(job), .group = &group});
+    }
+
+    {
+      std::scoped_lock lock(sleepMutex);
+      queued.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_one();
+  }
+
+  void ThreadPool::wait(JobGroup& group) {
+    size_t home = currentQueue();
+    while (!group.done()) {
+      if (!runOne(home)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  bool ThreadPool::runOne(size_t home) {
+    Task task;
+    bool found = false;
+
+    {
+      Queue& queue = *queues[home];
+      std::scoped_lock lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        found = true;
+      }
+    }
+
+    for (size_t offset = 1; !found && offset < queues.size(); ++offset) {
+      Queue& victim = *queues[(home + offset) % queues.size()];
+      std::scoped_lock lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        found = true;
+      }
+    }
+
+    if (!found) {
+      return false;
+    }
+
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    task.job();
+    task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+  }
+
+  void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+      if (runOne(index)) {
+        continue;
+      }
+
+      std::unique_lock lock(sleepMutex);
+      wake.wait(lock, [this] {
+        return stopping || queued.load(std::memory_order_acquire) > 0;
+      });
+      if (stopping) {
+        return;
+      }
+    }
+  }
+} // namespace keptech::ecs
@@ -4,6 +4,8 @@
 #include <imgui/backends/imgui_impl_sdl3.h>
 #include <imgui/imgui.h>
 #include <keptech/core/cameras/cameraManager.hpp>
+#include <keptech/core/components/spatialIndex.hpp>
+#include <keptech/core/components/transformSystem.hpp>
 #include <keptech/core/kt-logger.hpp>
 #include <keptech/core/renderer.hpp>
 #include <keptech/core/window.hpp>
@@ -41,6 +43,16 @@ namespace keptech {
 
     ecs.registerSystem<core::cameras::CameraManager>(
         core::cameras::CameraManager::getSignature());
+    ecs.setSystemAccess<core::cameras::CameraManager>(
+        ecs.access<const core::cameras::Camera>());
+    ecs.registerSystem<components::TransformSystem>(
+        components::TransformSystem::getSignature());
+    ecs.setSystemAccess<components::TransformSystem>(
+        ecs.access<components::Transform>());
+    ecs.registerSystem<components::SpatialIndex>(
+        components::SpatialIndex::getSignature());
+    ecs.setSystemAccess<components::SpatialIndex>(
+        ecs.access<const components::Transform, const components::Bounds>());
 
     std::expected<R*, std::string> rendererRes =
         R::create(rendererCreateInfo, window);
@@ -130,8 +142,11 @@ namespace keptech {
       renderer.newFrame();
 
       ecs.preUpdateAllSystems(frameData);
+      ecs.flushCommands();
       ecs.updateAllSystems(frameData);
+      ecs.flushCommands();
       ecs.postUpdateAllSystems(frameData);
+      ecs.flushCommands();
 
       renderer.render();
     }
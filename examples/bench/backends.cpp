@@ -0,0 +1,147 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <keptech/ecs/archetypeManager.hpp>
+#include <keptech/ecs/componentManager.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+  using keptech::ecs::EntityHandle;
+
+  struct LocalTransform {
+    float position[3];
+    float rotation[4];
+    float scale[3];
+  };
+
+  struct WorldMatrix {
+    float m[16];
+  };
+
+  struct Velocity {
+    float v[3];
+  };
+
+  /// Carried by a quarter of the entities, splitting them across archetypes.
+  struct Renderable {
+    uint32_t mesh;
+  };
+
+  void toMatrix(const LocalTransform& local, WorldMatrix& world) {
+    const float* q = local.rotation;
+    const float* s = local.scale;
+    float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+    float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+    float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+    world = WorldMatrix{{
+        (1.0f - 2.0f * (yy + zz)) * s[0],
+        2.0f * (xy + wz) * s[0],
+        2.0f * (xz - wy) * s[0],
+        0.0f,
+        2.0f * (xy - wz) * s[1],
+        (1.0f - 2.0f * (xx + zz)) * s[1],
+        2.0f * (yz + wx) * s[1],
+        0.0f,
+        2.0f * (xz + wy) * s[2],
+        2.0f * (yz - wx) * s[2],
+        (1.0f - 2.0f * (xx + yy)) * s[2],
+        0.0f,
+        local.position[0],
+        local.position[1],
+        local.position[2],
+        1.0f,
+    }};
+  }
+
+  struct Timings {
+    double populate;
+    double integrate;
+    double matrices;
+    double lookup;
+  };
+
+  /// A transform heavy scene: every entity moves and has its world matrix
+  /// rebuilt each frame, and a quarter of them are also renderable.
+  template <typename Storage> Timings runScene(size_t count) {
+    std::vector<EntityHandle> entities(count);
+    for (size_t i = 0; i < count; ++i) {
+      entities[i] = keptech::ecs::makeEntityHandle(
+          static_cast<keptech::ecs::EntityIndex>(i), 0);
+    }
+
+    auto populate = [&](Storage& storage) {
+      for (auto entity : entities) {
+        storage.add(entity, LocalTransform{.position = {0.0f, 0.0f, 0.0f},
+                                           .rotation = {0.0f, 0.0f, 0.0f, 1.0f},
+                                           .scale = {1.0f, 1.0f, 1.0f}});
+        storage.add(entity, WorldMatrix{});
+        storage.add(entity, Velocity{.v = {1.0f, 0.5f, 0.25f}});
+        if (entity % 4 == 0) {
+          storage.add(entity, Renderable{.mesh = entity});
+        }
+      }
+    };
+
+    Timings timings{};
+    timings.populate = bench::measure(
+        count,
+        [&] {
+          Storage storage;
+          populate(storage);
+        },
+        3);
+
+    Storage storage;
+    populate(storage);
+
+    timings.integrate = bench::measure(count, [&] {
+      storage.template view<const Velocity, LocalTransform>().each(
+          [](const Velocity& velocity, LocalTransform& local) {
+            for (int i = 0; i < 3; ++i) {
+              local.position[i] += velocity.v[i] * (1.0f / 60.0f);
+            }
+          });
+    });
+
+    timings.matrices = bench::measure(count, [&] {
+      storage.template view<const LocalTransform, WorldMatrix>().each(
+          [](const LocalTransform& local, WorldMatrix& world) {
+            toMatrix(local, world);
+          });
+    });
+
+    std::vector<EntityHandle> shuffled = entities;
+    std::ranges::shuffle(shuffled, std::mt19937(42));
+    timings.lookup = bench::measure(count, [&] {
+      float sum = 0.0f;
+      for (auto entity : shuffled) {
+        if (const auto* world = storage.template get<WorldMatrix>(entity)) {
+          sum += world->m[12];
+        }
+      }
+      bench::consume(static_cast<uint64_t>(sum));
+    });
+
+    return timings;
+  }
+} // namespace
+
+namespace bench {
+  void backends() {
+    for (size_t count : SCALES) {
+      Timings sparse = runScene<keptech::ecs::ComponentManager>(count);
+      Timings archetypes = runScene<keptech::ecs::ArchetypeManager>(count);
+
+      report("populate", count, "sparse", sparse.populate, "archetype",
+             archetypes.populate);
+      report("integrate velocity", count, "sparse", sparse.integrate,
+             "archetype", archetypes.integrate);
+      report("world matrices", count, "sparse", sparse.matrices, "archetype",
+             archetypes.matrices);
+      report("random lookup", count, "sparse", sparse.lookup, "archetype",
+             archetypes.lookup);
+    }
+  }
+} // namespace bench
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+namespace bench {
+  /// Entity counts the ECS benchmarks run at.
+  constexpr std::array<size_t, 4> SCALES = {5'000, 10'000, 50'000, 100'000};
+
+  /// Written with the result of every measured run, so the work is not
+  /// optimised away.
+  inline volatile uint64_t sink = 0;
+
+  inline void consume(uint64_t value) { sink = value; }
+
+  /// Runs `fn` `runs` times and returns the fastest run, in nanoseconds per
+  /// each of its `ops` operations.
+  template <typename Fn> double measure(size_t ops, Fn&& fn, int runs = 7) {
+    using Clock = std::chrono::steady_clock;
+
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < runs; ++run) {
+      auto start = Clock::now();
+      fn();
+      std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    return best / static_cast<double>(ops);
+  }
+
+  /// Like `measure`, but calls `reset` untimed after every run, to undo what
+  /// `fn` did.
+  template <typename Fn, typename Reset>
+  double measure(size_t ops, Fn&& fn, Reset&& reset, int runs = 7) {
+    using Clock = std::chrono::steady_clock;
+
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < runs; ++run) {
+      auto start = Clock::now();
+      fn();
+      std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+      best = std::min(best, elapsed.count());
+      reset();
+    }
+    return best / static_cast<double>(ops);
+  }
+
+  /// Prints a measurement against its baseline, with the speedup over it.
+  inline void report(std::string_view name, size_t count,
+                     std::string_view baselineName, double baseline,
+                     std::string_view candidateName, double candidate) {
+    spdlog::info("{:<24} {:>7}  {:>10} {:9.2f} ns  {:>10} {:9.2f} ns  {:6.2f}x",
+                 name, count, baselineName, baseline, candidateName, candidate,
+                 baseline / candidate);
+  }
+
+  /// Sparse set component lookup and iteration against hash maps.
+  void sparseSet();
+  /// The sparse set and archetype storages on a transform heavy scene.
+  void backends();
+  /// Spawning entities in one frame, directly and through command buffers.
+  void spawn();
+  /// System membership kept in a SparseSet against a std::set.
+  void membership();
+  /// The batch transform kernels on 100k transforms against glm.
+  void transforms();
+} // namespace bench
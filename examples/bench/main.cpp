@@ -0,0 +1,40 @@
+#include "bench.hpp"
+
+#include <span>
+#include <string_view>
+
+namespace {
+  struct Benchmark {
+    std::string_view name;
+    void (*run)();
+  };
+
+  constexpr std::array BENCHMARKS = {
+      Benchmark{.name = "sparseSet", .run = bench::sparseSet},
+      Benchmark{.name = "backends", .run = bench::backends},
+      Benchmark{.name = "spawn", .run = bench::spawn},
+      Benchmark{.name = "membership", .run = bench::membership},
+      Benchmark{.name = "transforms", .run = bench::transforms},
+  };
+} // namespace
+
+/// Runs every benchmark, or only those named on the command line. Numbers are
+/// only meaningful from an optimised build.
+int main(int argc, char** argv) {
+  std::span<char*> args(argv, static_cast<size_t>(argc));
+
+  for (const auto& benchmark : BENCHMARKS) {
+    bool selected = args.size() <= 1 ||
+                    std::ranges::any_of(args.subspan(1), [&](const char* arg) {
+                      return benchmark.name == arg;
+                    });
+    if (!selected) {
+      continue;
+    }
+
+    spdlog::info("== {} ==", benchmark.name);
+    benchmark.run();
+  }
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <keptech/ecs/componentArray.hpp>
+#include <keptech/ecs/sparseSet.hpp>
+#include <random>
+#include <set>
+#include <span>
+#include <vector>
+
+namespace {
+  using keptech::ecs::EntityHandle;
+
+  struct Health {
+    int value;
+  };
+
+  /// Member counts of a system.
+  constexpr std::array<size_t, 3> MEMBERS = {1'000, 10'000, 100'000};
+} // namespace
+
+namespace bench {
+  void membership() {
+    for (size_t count : MEMBERS) {
+      // Members join in a scattered order, as entities are spawned and
+      // destroyed over time.
+      std::vector<EntityHandle> entities(count);
+      for (size_t i = 0; i < count; ++i) {
+        entities[i] = keptech::ecs::makeEntityHandle(
+            static_cast<keptech::ecs::EntityIndex>(i), 0);
+      }
+      std::ranges::shuffle(entities, std::mt19937(42));
+
+      std::set<EntityHandle> tree;
+      keptech::ecs::SparseSet packed;
+      keptech::ecs::ComponentArray<Health> healths;
+      for (auto entity : entities) {
+        tree.insert(entity);
+        packed.insert(entity);
+        healths.insert(entity, Health{.value = 100});
+      }
+
+      // A system's update: walk the members and touch a component of each.
+      auto update = [&](const auto& members) {
+        return measure(count, [&] {
+          int64_t sum = 0;
+          for (auto entity : members) {
+            sum += healths.at(entity).value;
+          }
+          consume(static_cast<uint64_t>(sum));
+        });
+      };
+      report("system update", count, "std::set", update(tree), "sparse set",
+             update(packed));
+
+      // Membership churn: a tenth of the members leave and join again.
+      std::span<const EntityHandle> churned(entities.data(), count / 10);
+      double treeChurn = measure(churned.size(), [&] {
+        for (auto entity : churned) {
+          tree.erase(entity);
+        }
+        for (auto entity : churned) {
+          tree.insert(entity);
+        }
+      });
+      double packedChurn = measure(churned.size(), [&] {
+        for (auto entity : churned) {
+          packed.erase(entity);
+        }
+        for (auto entity : churned) {
+          packed.insert(entity);
+        }
+      });
+      report("leave and rejoin", count, "std::set", treeChurn, "sparse set",
+             packedChurn);
+    }
+  }
+} // namespace bench
@@ -0,0 +1,90 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <keptech/ecs/componentArray.hpp>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+  using keptech::ecs::EntityHandle;
+
+  struct Position {
+    float x, y, z, w;
+  };
+
+  /// ComponentArray as it was before the sparse set, indexing the packed
+  /// components through a pair of hash maps.
+  template <typename T> class HashComponentArray {
+  public:
+    void insert(EntityHandle entity, T&& component) {
+      size_t index = components.size();
+      components.emplace_back(std::move(component));
+      entityToIndexMap[entity] = index;
+      indexToEntityMap[index] = entity;
+    }
+
+    T& at(EntityHandle entity) { return components[entityToIndexMap[entity]]; }
+
+  private:
+    std::vector<T> components;
+    std::unordered_map<EntityHandle, size_t> entityToIndexMap;
+    std::unordered_map<size_t, EntityHandle> indexToEntityMap;
+  };
+} // namespace
+
+namespace bench {
+  void sparseSet() {
+    for (size_t count : SCALES) {
+      std::vector<EntityHandle> entities(count);
+      for (size_t i = 0; i < count; ++i) {
+        entities[i] = keptech::ecs::makeEntityHandle(
+            static_cast<keptech::ecs::EntityIndex>(i), 0);
+      }
+
+      HashComponentArray<Position> hashed;
+      keptech::ecs::ComponentArray<Position> sparse;
+      for (auto entity : entities) {
+        auto value = static_cast<float>(entity);
+        hashed.insert(entity, Position{value, value, value, 1.0f});
+        sparse.insert(entity, Position{value, value, value, 1.0f});
+      }
+
+      // Lookups in random order, as systems fetching components of other
+      // entities do.
+      std::vector<EntityHandle> shuffled = entities;
+      std::ranges::shuffle(shuffled, std::mt19937(42));
+
+      auto lookup = [&](auto& array) {
+        return measure(count, [&] {
+          float sum = 0.0f;
+          for (auto entity : shuffled) {
+            sum += array.at(entity).x;
+          }
+          consume(static_cast<uint64_t>(sum));
+        });
+      };
+      report("random lookup", count, "hash map", lookup(hashed), "sparse set",
+             lookup(sparse));
+
+      // Iterating every component. Systems used to walk their entity list
+      // and look each one up, where the sparse set is walked linearly.
+      double hashedIteration = measure(count, [&] {
+        float sum = 0.0f;
+        for (auto entity : entities) {
+          sum += hashed.at(entity).x;
+        }
+        consume(static_cast<uint64_t>(sum));
+      });
+      double sparseIteration = measure(count, [&] {
+        float sum = 0.0f;
+        for (const auto& position : sparse) {
+          sum += position.x;
+        }
+        consume(static_cast<uint64_t>(sum));
+      });
+      report("iteration", count, "hash map", hashedIteration, "sparse set",
+             sparseIteration);
+    }
+  }
+} // namespace bench
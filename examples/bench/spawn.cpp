@@ -0,0 +1,107 @@
+#include "bench.hpp"
+
+#include <keptech/ecs/ecs.hpp>
+#include <vector>
+
+namespace {
+  using keptech::ecs::ECS;
+  using keptech::ecs::EntityHandle;
+
+  struct Position {
+    float x, y, z;
+  };
+
+  struct Velocity {
+    float x, y, z;
+  };
+
+  struct Health {
+    int value;
+  };
+
+  class MovementSystem : public keptech::ecs::System {};
+  class DamageSystem : public keptech::ecs::System {};
+  class PhysicsSystem : public keptech::ecs::System {};
+
+  /// Entities spawned in the one frame, as in a burst of particles or a level
+  /// streaming in.
+  constexpr size_t SPAWN_COUNT = 10'000;
+  /// Entities each job records when spawning from jobs.
+  constexpr size_t JOB_SIZE = 256;
+
+  void spawnDirect(ECS& ecs, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; ++i) {
+      EntityHandle entity = ecs.createEntity("spawned").getHandle();
+      ecs.addComponent(
+          entity, Position{.x = static_cast<float>(i), .y = 0.0f, .z = 0.0f});
+      ecs.addComponent(entity, Velocity{.x = 1.0f, .y = 0.0f, .z = 0.0f});
+      ecs.addComponent(entity, Health{.value = 100});
+    }
+  }
+
+  void record(keptech::ecs::EntityCommandBuffer& commands, size_t first,
+              size_t count) {
+    for (size_t i = first; i < first + count; ++i) {
+      auto entity = commands.createEntity("spawned");
+      commands.addComponent(
+          entity, Position{.x = static_cast<float>(i), .y = 0.0f, .z = 0.0f});
+      commands.addComponent(entity, Velocity{.x = 1.0f, .y = 0.0f, .z = 0.0f});
+      commands.addComponent(entity, Health{.value = 100});
+    }
+  }
+} // namespace
+
+namespace bench {
+  void spawn() {
+    ECS& ecs = ECS::get();
+    ecs.registerSystem<MovementSystem>(
+        ecs.signatureFromComponents<Position, Velocity>());
+    ecs.registerSystem<DamageSystem>(ecs.signatureFromComponents<Health>());
+    ecs.registerSystem<PhysicsSystem>(
+        ecs.signatureFromComponents<Position, Velocity, Health>());
+
+    std::vector<EntityHandle> spawned;
+    auto despawn = [&] {
+      for (const auto& [entity, position] : ecs.view<const Position>()) {
+        (void)position;
+        spawned.push_back(entity);
+      }
+      for (auto entity : spawned) {
+        ecs.destroyEntity(entity);
+      }
+      spawned.clear();
+    };
+
+    double direct = measure(
+        SPAWN_COUNT, [&] { spawnDirect(ecs, 0, SPAWN_COUNT); }, despawn);
+
+    double deferred = measure(
+        SPAWN_COUNT,
+        [&] {
+          record(ecs.commands(), 0, SPAWN_COUNT);
+          ecs.flushCommands();
+        },
+        despawn);
+
+    auto& pool = ecs.getThreadPool();
+    double jobs = measure(
+        SPAWN_COUNT,
+        [&] {
+          keptech::ecs::JobGroup group;
+          for (size_t first = 0; first < SPAWN_COUNT; first += JOB_SIZE) {
+            pool.submit(
+                [&ecs, first] {
+                  record(ecs.commands(), first,
+                         std::min(JOB_SIZE, SPAWN_COUNT - first));
+                },
+                group);
+          }
+          pool.wait(group);
+          ecs.flushCommands();
+        },
+        despawn);
+
+    report("spawn", SPAWN_COUNT, "direct", direct, "deferred", deferred);
+    report("spawn from jobs", SPAWN_COUNT, "direct", direct, "jobs", jobs);
+  }
+} // namespace bench
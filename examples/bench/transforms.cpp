@@ -0,0 +1,119 @@
+#include "bench.hpp"
+
+#include <bit>
+#include <cmath>
+#include <keptech/core/maths/transformBatch.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+  using keptech::maths::Transform;
+
+  /// Transforms the batch kernels are measured on.
+  constexpr size_t COUNT = 100'000;
+
+  std::vector<Transform> randomTransforms(size_t count) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    std::vector<Transform> transforms(count);
+    for (auto& transform : transforms) {
+      glm::quat rotation(unit(random), unit(random), unit(random),
+                         unit(random));
+      float length =
+          std::sqrt(rotation.w * rotation.w + rotation.x * rotation.x +
+                    rotation.y * rotation.y + rotation.z * rotation.z);
+      transform.setPosition({position(random), position(random),
+                             position(random)})
+          .setRotation(glm::quat(rotation.w / length, rotation.x / length,
+                                 rotation.y / length, rotation.z / length))
+          .setScale({scale(random), scale(random), scale(random)});
+    }
+    return transforms;
+  }
+
+  float first(const glm::mat4& matrix) { return matrix[0][0]; }
+  float first(const keptech::maths::Matrix3x4& matrix) {
+    return matrix.rows[0][0];
+  }
+
+  /// Folds the matrices into the sink, so writing them is not optimised
+  /// away.
+  template <typename Matrix> void consumeAll(const std::vector<Matrix>& out) {
+    uint64_t sum = 0;
+    for (const auto& matrix : out) {
+      sum += std::bit_cast<uint32_t>(first(matrix));
+    }
+    bench::consume(sum);
+  }
+
+  /// Largest difference between any two elements of the matrices.
+  float maxDifference(const std::vector<glm::mat4>& a,
+                      const std::vector<glm::mat4>& b) {
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+      for (glm::length_t column = 0; column < 4; ++column) {
+        for (glm::length_t row = 0; row < 4; ++row) {
+          difference = std::max(
+              difference, std::abs(a[i][column][row] - b[i][column][row]));
+        }
+      }
+    }
+    return difference;
+  }
+} // namespace
+
+namespace bench {
+  void transforms() {
+    auto transforms = randomTransforms(COUNT);
+    keptech::maths::TransformBatch batch;
+    batch.reserve(COUNT);
+    for (const auto& transform : transforms) {
+      batch.push(transform);
+    }
+
+    std::vector<glm::mat4> expected(COUNT);
+    std::vector<glm::mat4> matrices(COUNT);
+    std::vector<keptech::maths::Matrix3x4> compact(COUNT);
+
+    double scalar = measure(COUNT, [&] {
+      for (size_t i = 0; i < COUNT; ++i) {
+        expected[i] = transforms[i].toMatrix();
+      }
+      consumeAll(expected);
+    });
+    double batched = measure(COUNT, [&] {
+      keptech::maths::toMatrices(batch, std::span(matrices));
+      consumeAll(matrices);
+    });
+    double batchedCompact = measure(COUNT, [&] {
+      keptech::maths::toMatrices(batch, std::span(compact));
+      consumeAll(compact);
+    });
+    report("to matrices", COUNT, "glm", scalar, "batch", batched);
+    report("to 3x4 matrices", COUNT, "glm", scalar, "batch", batchedCompact);
+    spdlog::info("max difference from glm: {}",
+                 maxDifference(expected, matrices));
+
+    // Child world matrices from their parents' world and their own local
+    // matrices.
+    std::vector<glm::mat4> parents(expected.rbegin(), expected.rend());
+    std::vector<glm::mat4> worlds(COUNT);
+    double scalarMultiply = measure(COUNT, [&] {
+      for (size_t i = 0; i < COUNT; ++i) {
+        expected[i] = parents[i] * matrices[i];
+      }
+      consumeAll(expected);
+    });
+    double batchedMultiply = measure(COUNT, [&] {
+      keptech::maths::multiplyMatrices(parents, matrices, worlds);
+      consumeAll(worlds);
+    });
+    report("multiply matrices", COUNT, "glm", scalarMultiply, "batch",
+           batchedMultiply);
+    spdlog::info("max difference from glm: {}",
+                 maxDifference(expected, worlds));
+  }
+} // namespace bench
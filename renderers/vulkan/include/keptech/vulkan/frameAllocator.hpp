@@ -0,0 +1,141 @@
+#pragma once
+
+#include "structs.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <expected>
+#include <span>
+#include <string>
+#include <vector>
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace keptech::vkh {
+  /// Linear allocator for data written by the CPU once per frame, such as
+  /// camera uniforms, instance data and material parameters.
+  ///
+  /// Each frame in flight owns persistently mapped blocks that allocations
+  /// are bumped out of, and that are only reset once the frame's fence has
+  /// been waited on. Every allocation therefore gets memory the GPU is not
+  /// reading, and the host writes need no barriers, as submission makes
+  /// them visible.
+  ///
+  /// Allocations are read either through their device address, or as a
+  /// dynamic uniform buffer through their block's `uniformSet`, with their
+  /// offset as the dynamic offset. A frame that runs out of space chains
+  /// another block, and the next time the frame starts its blocks are
+  /// merged into one large enough for the whole frame.
+  class FrameAllocator {
+  public:
+    struct Allocation {
+      uint8_t* data;
+      vk::Buffer buffer;
+      vk::DeviceSize offset;
+      vk::DeviceAddress address;
+      /// Dynamic uniform buffer of `uniformRange` bytes over the block.
+      vk::DescriptorSet uniformSet;
+
+      [[nodiscard]] uint32_t dynamicOffset() const {
+        return static_cast<uint32_t>(offset);
+      }
+    };
+
+    /// `uniformLayout` must hold a single dynamic uniform buffer at binding
+    /// 0, read `uniformRange` bytes at a time.
+    static std::expected<FrameAllocator, std::string>
+    create(const vk::raii::Device& device, vma::Allocator& allocator,
+           const vk::PhysicalDeviceLimits& limits,
+           const vk::raii::DescriptorSetLayout& uniformLayout,
+           vk::DeviceSize uniformRange);
+
+    FrameAllocator(const FrameAllocator&) = delete;
+    FrameAllocator& operator=(const FrameAllocator&) = delete;
+    FrameAllocator(FrameAllocator&&) noexcept = default;
+    FrameAllocator& operator=(FrameAllocator&&) noexcept = default;
+    ~FrameAllocator() = default;
+
+    /// Frees everything allocated for `frameIndex`. Its previous submission
+    /// must have completed.
+    std::expected<void, std::string> reset(const vk::raii::Device& device,
+                                           uint8_t frameIndex);
+
+    std::expected<Allocation, std::string>
+    allocate(const vk::raii::Device& device, uint8_t frameIndex,
+             vk::DeviceSize size, vk::DeviceSize alignment);
+
+    /// Copies `value` into an allocation suitably aligned to be bound as a
+    /// dynamic uniform buffer.
+    template <typename T>
+    std::expected<Allocation, std::string>
+    uniform(const vk::raii::Device& device, uint8_t frameIndex,
+            const T& value) {
+      auto allocation = allocate(
+          device, frameIndex,
+          std::max<vk::DeviceSize>(sizeof(T), uniformRange), uniformAlignment);
+      if (allocation) {
+        memcpy(allocation->data, &value, sizeof(T));
+      }
+      return allocation;
+    }
+
+    /// Copies `values` into an allocation read through its address.
+    template <typename T>
+    std::expected<Allocation, std::string>
+    upload(const vk::raii::Device& device, uint8_t frameIndex,
+           std::span<const T> values) {
+      auto allocation =
+          allocate(device, frameIndex, values.size_bytes(),
+                   std::max<vk::DeviceSize>(alignof(T), ADDRESS_ALIGNMENT));
+      if (allocation) {
+        memcpy(allocation->data, values.data(), values.size_bytes());
+      }
+      return allocation;
+    }
+
+    /// Flushes the frame's writes, for memory that is not host coherent.
+    void flush(uint8_t frameIndex);
+
+    void destroy();
+
+  private:
+    /// Blocks start at this size, and double whenever a frame runs out.
+    constexpr static vk::DeviceSize MIN_BLOCK_SIZE = 256 * 1024;
+    /// Blocks a single frame may chain before allocations fail.
+    constexpr static uint32_t MAX_BLOCKS = 8;
+    /// Alignment of allocations read through their address, enough for any
+    /// vector or matrix.
+    constexpr static vk::DeviceSize ADDRESS_ALIGNMENT = 16;
+
+    struct Block {
+      AddressedAllocatedBuffer buffer;
+      vk::DeviceSize size;
+      vk::DeviceSize used = 0;
+      vk::raii::DescriptorSet uniformSet;
+    };
+
+    struct Frame {
+      std::vector<Block> blocks;
+      /// Block allocations are currently bumped out of.
+      size_t current = 0;
+    };
+
+    FrameAllocator(vma::Allocator& allocator, vk::raii::DescriptorPool&& pool,
+                   vk::DescriptorSetLayout uniformLayout,
+                   vk::DeviceSize uniformRange,
+                   vk::DeviceSize uniformAlignment)
+        : allocator(allocator), pool(std::move(pool)),
+          uniformLayout(uniformLayout), uniformRange(uniformRange),
+          uniformAlignment(uniformAlignment) {}
+
+    std::expected<Block, std::string>
+    createBlock(const vk::raii::Device& device, vk::DeviceSize size);
+
+    vma::Allocator allocator;
+    vk::raii::DescriptorPool pool;
+    vk::DescriptorSetLayout uniformLayout;
+    vk::DeviceSize uniformRange;
+    vk::DeviceSize uniformAlignment;
+    std::array<Frame, MAX_FRAMES_IN_FLIGHT> frames = {};
+  };
+} // namespace keptech::vkh
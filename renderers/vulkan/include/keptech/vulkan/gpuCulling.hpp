@@ -0,0 +1,158 @@
+#pragma once
+
+#include "material.hpp"
+#include "mesh.hpp"
+#include "pipelineCache.hpp"
+#include "structs.hpp"
+#include <array>
+#include <expected>
+#include <glm/glm.hpp>
+#include <keptech/core/maths/frustum.hpp>
+#include <span>
+#include <vector>
+#include <vk_mem_alloc.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace keptech::vkh {
+  /// Frustum culling on the GPU for the GPU-driven forward pass.
+  ///
+  /// Every frame the renderer fills `instances`, `draws` and `batches` with
+  /// the whole scene. `cull` uploads them and records a compute pass that
+  /// tests each draw against every view, appending the survivors as indirect
+  /// commands to their batch. `drawBatch` then issues a batch with a single
+  /// indirect count draw, so recording costs one call per batch no matter
+  /// how many objects it holds.
+  class GpuCulling {
+  public:
+    /// One submesh of one instance. Mirrors Draw in cull.slang.
+    struct Draw {
+      uint32_t instance;
+      uint32_t batch;
+      /// First command slot of the batch within a view.
+      uint32_t commandBase;
+      uint32_t indexed;
+      /// Index or vertex count and first index or vertex.
+      uint32_t count;
+      uint32_t first;
+      std::array<uint32_t, 2> padding = {};
+    };
+
+    /// Draws sharing a pipeline and mesh, so they need no state changes
+    /// between them. `material` is any of the materials drawn.
+    struct Batch {
+      const Material* material;
+      const Mesh* mesh;
+      uint32_t commandBase;
+      uint32_t drawCount;
+    };
+
+    static std::expected<GpuCulling, std::string>
+    create(const vk::raii::Device& device, vma::Allocator& allocator,
+           const PipelineCache& pipelineCache, uint32_t graphicsFamily,
+           uint32_t computeFamily);
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+    GpuCulling(GpuCulling&&) noexcept = default;
+    GpuCulling& operator=(GpuCulling&&) noexcept = default;
+    ~GpuCulling() = default;
+
+    /// Clears the scene ahead of filling it for a new frame.
+    void clear() {
+      instances.clear();
+      draws.clear();
+      batches.clear();
+    }
+
+    /// Uploads the scene for `frameIndex` and records the culling pass for
+    /// each of `views` into `cmd`. Indirect commands are ready once the
+    /// submission of `cmd` has completed.
+    std::expected<void, std::string>
+    cull(const vk::raii::Device& device, uint8_t frameIndex,
+         const vk::raii::CommandBuffer& cmd,
+         std::span<const maths::Frustum> views);
+
+    /// Records the indirect draw of `batches[batch]` as culled for `view`.
+    /// The material's pipeline and instance address must already be bound.
+    void drawBatch(uint8_t frameIndex, const vk::raii::CommandBuffer& cmd,
+                   uint32_t view, uint32_t batch) const;
+
+    /// Address of the frame's instance buffer, pushed to material shaders.
+    [[nodiscard]] vk::DeviceAddress instanceAddress(uint8_t frameIndex) const {
+      return frames[frameIndex].instances.address;
+    }
+
+    /// Signalled by the culling pass, waited on before indirect draws.
+    [[nodiscard]] const vk::raii::Semaphore&
+    getSemaphore(uint8_t frameIndex) const {
+      return frames[frameIndex].cullComplete;
+    }
+
+    /// Views culled this frame.
+    [[nodiscard]] uint32_t viewCount() const { return culledViews; }
+
+    void destroy();
+
+    std::vector<InstanceData> instances;
+    std::vector<Draw> draws;
+    std::vector<Batch> batches;
+
+  private:
+    /// Invocations per workgroup of cull.slang.
+    constexpr static uint32_t WORKGROUP_SIZE = 64;
+    /// Buffers never shrink, and start with room for this many elements.
+    constexpr static size_t MIN_CAPACITY = 64;
+    /// Indexed and non-indexed commands share one stride.
+    constexpr static uint32_t COMMAND_STRIDE =
+        sizeof(vk::DrawIndexedIndirectCommand);
+
+    struct Frame {
+      AddressedAllocatedBuffer instances;
+      AllocatedBuffer draws;
+      AllocatedBuffer commands;
+      AllocatedBuffer counts;
+      /// Element capacity of each buffer.
+      size_t instanceCapacity = 0;
+      size_t drawCapacity = 0;
+      size_t commandCapacity = 0;
+      size_t countCapacity = 0;
+
+      vk::raii::DescriptorSet descriptorSet;
+      vk::raii::Semaphore cullComplete;
+    };
+
+    GpuCulling(vma::Allocator& allocator,
+               vk::raii::DescriptorSetLayout&& layout,
+               vk::raii::DescriptorPool&& pool,
+               vk::raii::PipelineLayout&& pipelineLayout,
+               vk::raii::Pipeline&& pipeline,
+               std::array<Frame, MAX_FRAMES_IN_FLIGHT>&& frames,
+               std::array<uint32_t, 2> queueFamilies)
+        : allocator(allocator), layout(std::move(layout)),
+          pool(std::move(pool)),
+          pipelineLayout(std::move(pipelineLayout)),
+          pipeline(std::move(pipeline)), frames(std::move(frames)),
+          queueFamilies(queueFamilies) {}
+
+    /// Grows the frame's buffers to fit the scene and `viewCount` views,
+    /// rewriting its descriptors if any were replaced.
+    std::expected<void, std::string> reserve(const vk::raii::Device& device,
+                                             Frame& frame, uint32_t viewCount);
+
+    std::expected<AllocatedBuffer, std::string>
+    createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+                 bool hostVisible);
+
+    vma::Allocator allocator;
+    vk::raii::DescriptorSetLayout layout;
+    vk::raii::DescriptorPool pool;
+    vk::raii::PipelineLayout pipelineLayout;
+    vk::raii::Pipeline pipeline;
+    std::array<Frame, MAX_FRAMES_IN_FLIGHT> frames;
+    /// Graphics and compute families. Buffers are shared between them when
+    /// they differ.
+    std::array<uint32_t, 2> queueFamilies;
+
+    uint32_t culledViews = 0;
+  };
+} // namespace keptech::vkh
@@ -5,7 +5,11 @@
 
 namespace keptech::vkh {
   struct Material : public core::rendering::Material {
-    vk::raii::Pipeline pipeline;
-    vk::raii::PipelineLayout pipelineLayout;
+    /// Owned by the renderer's PipelineRegistry, and shared with every
+    /// material created from the same config.
+    vk::Pipeline pipeline;
+    vk::PipelineLayout pipelineLayout;
+    /// Registry id of the pipeline.
+    uint32_t pipelineId;
   };
 } // namespace keptech::vkh
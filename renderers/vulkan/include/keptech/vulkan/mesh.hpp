@@ -13,8 +13,8 @@ namespace keptech::vkh {
     Mesh(std::string name, AddressedAllocatedBuffer vBuffer,
          std::optional<AllocatedBuffer> iBuffer,
          std::vector<core::rendering::Mesh::Submesh> submeshes,
-         vma::Allocator& allocator)
-        : core::rendering::Mesh{std::move(name), std::move(submeshes)},
+         maths::Bounds bounds, vma::Allocator& allocator)
+        : core::rendering::Mesh{std::move(name), std::move(submeshes), bounds},
           vertexBuffer(vBuffer), indexBuffer(iBuffer), allocator(&allocator) {}
 
     Mesh() = delete;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace keptech::vkh {
+  /// vk::PipelineCache kept on disk between runs.
+  ///
+  /// The file starts with a header naming the device and driver that wrote
+  /// it, and a checksum of the cache data. A file from another device or
+  /// driver, or one that fails validation, is ignored and the cache starts
+  /// empty. Saving writes a temporary file next to the cache and renames it
+  /// over the old one, so a crash mid-save never leaves a torn file behind.
+  ///
+  /// With an empty path the cache only lives in memory.
+  class PipelineCache {
+  public:
+    static std::expected<PipelineCache, std::string>
+    create(const vk::raii::Device& device,
+           const vk::raii::PhysicalDevice& physicalDevice,
+           std::filesystem::path path);
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+    PipelineCache(PipelineCache&&) noexcept = default;
+    PipelineCache& operator=(PipelineCache&&) noexcept = default;
+    ~PipelineCache() = default;
+
+    /// Writes the cache to disk, if it has a path.
+    std::expected<void, std::string> save() const;
+
+    [[nodiscard]] const vk::raii::PipelineCache& get() const { return cache; }
+    const vk::raii::PipelineCache& operator*() const { return cache; }
+
+  private:
+    /// Identifies the device and driver a cache file was written by.
+    struct Header {
+      std::array<char, 4> magic;
+      uint32_t version;
+      uint32_t vendorID;
+      uint32_t deviceID;
+      uint32_t driverVersion;
+      uint32_t padding;
+      uint64_t dataSize;
+      uint64_t checksum;
+      std::array<uint8_t, vk::UuidSize> deviceUUID;
+      std::array<uint8_t, vk::UuidSize> pipelineCacheUUID;
+    };
+    static_assert(sizeof(Header) == 72,
+                  "Header is written as is, so must not be padded");
+
+    PipelineCache(vk::raii::PipelineCache&& cache, std::filesystem::path path,
+                  const Header& header)
+        : cache(std::move(cache)), path(std::move(path)), header(header) {}
+
+    static Header makeHeader(const vk::raii::PhysicalDevice& physicalDevice);
+
+    /// Reads the cache data at `path`, or nothing if it is missing or was
+    /// not written for the device `expected` describes.
+    static std::vector<uint8_t> load(const std::filesystem::path& path,
+                                     const Header& expected);
+
+    vk::raii::PipelineCache cache;
+    std::filesystem::path path;
+    /// Header of files saved on this device, minus the data fields.
+    Header header;
+  };
+} // namespace keptech::vkh
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace keptech::vkh {
+  /// Graphics pipelines and layouts shared by every material created from
+  /// the same config.
+  ///
+  /// Pipelines are keyed by the contents of their config, so materials
+  /// built from identical shaders and state reuse one pipeline rather than
+  /// compiling their own, and sort and draw as one. Every material holds a
+  /// reference, dropped when its handle is, and the last reference destroys
+  /// the pipeline.
+  class PipelineRegistry {
+  public:
+    struct Entry {
+      vk::raii::Pipeline pipeline;
+      vk::raii::PipelineLayout layout;
+      /// Never reused, so it may stand in for the pipeline in sort keys.
+      uint32_t id;
+      uint32_t refs;
+      std::string key;
+    };
+
+    /// Adds a reference to the pipeline built for `key`, if there is one.
+    Entry* acquire(const std::string& key);
+
+    /// Registers a pipeline built for `key`, holding one reference.
+    Entry& insert(std::string key, vk::raii::Pipeline&& pipeline,
+                  vk::raii::PipelineLayout&& layout);
+
+    /// Drops a reference to pipeline `id`, destroying it with the last.
+    void release(uint32_t id);
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+    void clear() {
+      ids.clear();
+      entries.clear();
+    }
+
+  private:
+    std::unordered_map<std::string, uint32_t> ids;
+    std::unordered_map<uint32_t, Entry> entries;
+    uint32_t nextId = 0;
+  };
+} // namespace keptech::vkh
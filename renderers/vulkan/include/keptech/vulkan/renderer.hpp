@@ -1,5 +1,7 @@
 #pragma once
 
+#include "keptech/vulkan/frameAllocator.hpp"
+#include "keptech/vulkan/gpuCulling.hpp"
 #include "keptech/vulkan/helpers/descriptors.hpp"
 #include "keptech/vulkan/helpers/device.hpp"
 #include "keptech/vulkan/helpers/pipeline.hpp"
@@ -7,6 +9,8 @@
 #include "keptech/vulkan/helpers/swapchain.hpp"
 #include "keptech/vulkan/material.hpp"
 #include "keptech/vulkan/mesh.hpp"
+#include "keptech/vulkan/pipelineCache.hpp"
+#include "keptech/vulkan/pipelineRegistry.hpp"
 #include <algorithm>
 #include <expected>
 #include <functional>
@@ -21,8 +25,10 @@
 #include <keptech/ecs/ecs.hpp>
 #include <keptech/vulkan/structs.hpp>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vk_mem_alloc.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
@@ -54,8 +60,20 @@ namespace keptech::vkh {
       std::shared_ptr<CommandPool> graphics;
       std::shared_ptr<CommandPool> present;
       std::shared_ptr<CommandPool> compute;
-
+      /// Graphics family pools for secondary command buffers recorded by
+      /// jobs, indexed by `ecs::ThreadPool::threadIndex`.
+      std::vector<CommandPool> recording = {};
+
+      /// Grows `recording` to a pool for each of `threads`. The thread pool
+      /// may be restarted with more workers, so this runs before each batch
+      /// of recording jobs.
+      std::expected<void, std::string>
+      reserveRecording(const vk::raii::Device& device, size_t threads);
       void resetAll();
+      /// Command buffers allocated from the pools since they were reset.
+      [[nodiscard]] uint32_t allocationCount() const;
+      /// The pools, each once even where queues share a family.
+      [[nodiscard]] std::set<CommandPool*> unique() const;
     };
 
     struct SyncObjects {
@@ -69,6 +87,50 @@ namespace keptech::vkh {
       Pools pools;
     };
 
+    /// Times a piece of draw state was set, and times setting it was skipped
+    /// because the previous draw already had it bound.
+    struct StateChanges {
+      uint32_t emitted = 0;
+      uint32_t saved = 0;
+
+      void record(bool changed) { ++(changed ? emitted : saved); }
+
+      StateChanges& operator+=(const StateChanges& other) {
+        emitted += other.emitted;
+        saved += other.saved;
+        return *this;
+      }
+    };
+
+    /// Counters from the last rendered frame.
+    struct FrameStats {
+      /// Draw calls recorded, with indirect draws counting once.
+      uint32_t draws = 0;
+      /// Instances drawn by the CPU recorded path.
+      uint32_t instances = 0;
+      /// vkAllocateCommandBuffers calls, zero once the frame's pools hold
+      /// enough command buffers to be recycled.
+      uint32_t commandBufferAllocations = 0;
+      StateChanges pipelineBinds;
+      StateChanges descriptorSetBinds;
+      StateChanges pushConstants;
+      StateChanges indexBufferBinds;
+      StateChanges viewports;
+
+      /// Adds the draw counters of `other`, recorded into another command
+      /// buffer.
+      FrameStats& operator+=(const FrameStats& other) {
+        draws += other.draws;
+        instances += other.instances;
+        pipelineBinds += other.pipelineBinds;
+        descriptorSetBinds += other.descriptorSetBinds;
+        pushConstants += other.pushConstants;
+        indexBufferBinds += other.indexBufferBinds;
+        viewports += other.viewports;
+        return *this;
+      }
+    };
+
     struct OldSwapchain {
       vkh::Swapchain swapchain;
       uint8_t frameIndex;
@@ -91,11 +153,10 @@ namespace keptech::vkh {
       vk::raii::DescriptorPool descriptorPool;
     };
 
+    /// Camera uniforms are allocated per camera from the FrameAllocator,
+    /// and bound through a dynamic uniform buffer at set 0.
     struct CameraObjects {
       vk::raii::DescriptorSetLayout layout;
-      vk::raii::DescriptorPool pool;
-      vk::raii::DescriptorSet descriptorSet;
-      AllocatedBuffer uniformBuffer;
     };
 
     struct Frame {
@@ -110,10 +171,15 @@ namespace keptech::vkh {
   private:
     Renderer(const core::window::Window& window, VulkanCore&& vkcore,
              vma::Allocator& allocator, ImGuiVkObjects&& imGuiObjects,
-             CameraObjects&& cameraObjects)
+             CameraObjects&& cameraObjects, FrameAllocator&& frameAllocator,
+             PipelineCache&& pipelineCache,
+             std::optional<GpuCulling>&& gpuCulling)
         : window(&window), vkcore(std::move(vkcore)), allocator(allocator),
+          pipelineCache(std::move(pipelineCache)),
           imGuiObjects(std::move(imGuiObjects)),
-          cameraObjects(std::move(cameraObjects)) {}
+          cameraObjects(std::move(cameraObjects)),
+          frameAllocator(std::move(frameAllocator)),
+          gpuCulling(std::move(gpuCulling)) {}
 
     template <typename... Args> static Renderer& addToEcs(Renderer&& renderer) {
       auto& ecs = ecs::ECS::get();
@@ -153,6 +219,19 @@ namespace keptech::vkh {
 
     void render();
 
+    [[nodiscard]] const FrameStats& getFrameStats() const { return frameStats; }
+
+    /// Writes compiled pipelines to `CreateInfo::pipelineCachePath`, which
+    /// also happens on shutdown.
+    std::expected<void, std::string> savePipelineCache() const {
+      return pipelineCache.save();
+    }
+
+    /// Queues new render objects to be given the Bounds of their mesh.
+    void onEntityAdded(ecs::EntityHandle entity) override {
+      pendingBounds.push_back(entity);
+    }
+
     ~Renderer() override;
 
   private:
@@ -161,9 +240,11 @@ namespace keptech::vkh {
     }
 
     struct VkRenderObject {
-      keptech::maths::Transform transform;
+      glm::mat4 transform;
       vkh::Material* material = nullptr;
       vkh::Mesh* mesh = nullptr;
+      /// Order within its list, see `makeSortKey`.
+      uint64_t sortKey = 0;
     };
 
     struct ObjectLists {
@@ -172,29 +253,73 @@ namespace keptech::vkh {
       std::vector<VkRenderObject> transparent;
     };
 
-    ObjectLists buildRenderObjectLists(const maths::Frustum& frustum);
+    /// Lists the render objects inside the frustum, each sorted by key for
+    /// a camera at `eye`.
+    ObjectLists buildRenderObjectLists(const maths::Frustum& frustum,
+                                       const glm::vec3& eye);
+
+    /// Fills `gpuCulling` with every forward render object, grouped into
+    /// batches by pipeline and mesh.
+    void buildGpuScene();
+    /// Records and submits the culling pass for every camera on the compute
+    /// queue, signalling the frame's culling semaphore.
+    void cullOnGpu(const Frame& info);
+
+    /// Adds Bounds from the mesh to pending render objects whose mesh has
+    /// loaded, so the SpatialIndex can cull them. Entities given Bounds by
+    /// the application keep their own.
+    void attachMeshBounds();
 
     void checkSwapchain();
     std::expected<void, std::string> recreateSwapchain();
 
+    /// Compiles the pipeline and layout for a material config.
+    std::expected<std::pair<vk::raii::Pipeline, vk::raii::PipelineLayout>,
+                  std::string>
+    createPipeline(const core::rendering::PipelineCreateInfo& createInfo);
+    /// Frees a material, and its pipeline if no other material shares it.
+    void destroyMaterial(core::SlotMapHandle handle);
+
     Frame startFrame();
     void
     setupGraphicsCommandBuffer(const Frame& info,
                                const vk::raii::CommandBuffer& graphicsCmdBuffer,
-                               const core::cameras::Camera& camera);
+                               const core::cameras::Camera& camera) const;
     void draw(const Frame& info,
               const vk::raii::CommandBuffer& graphicsCmdBuffer);
+    /// Binds the camera's uniforms for `layout`.
+    void bindCamera(const vk::raii::CommandBuffer& graphicsCmdBuffer,
+                    vk::PipelineLayout layout,
+                    const FrameAllocator::Allocation& cameraUniforms) const;
+    /// Records the forward pass of a camera inside `renderingInfo`. Large
+    /// lists are split into chunks recorded into secondary command buffers
+    /// by jobs, which the primary then executes in order.
+    void drawForward(const Frame& info,
+                     const vk::raii::CommandBuffer& graphicsCmdBuffer,
+                     const vk::RenderingInfo& renderingInfo,
+                     const core::cameras::Camera& camera,
+                     const FrameAllocator::Allocation& cameraUniforms,
+                     const maths::Frustum& frustum);
+    /// Records draws of `objects`, whose instance data starts at index
+    /// `firstInstance` of the buffer at `instanceAddress`. Only reads
+    /// renderer state, so jobs may record several chunks at once.
+    void recordObjects(const Frame& info, const vk::raii::CommandBuffer& cmd,
+                       const core::cameras::Camera& camera,
+                       const FrameAllocator::Allocation& cameraUniforms,
+                       std::span<const VkRenderObject> objects,
+                       vk::DeviceAddress instanceAddress,
+                       uint32_t firstInstance, FrameStats& stats) const;
+    /// Draws the batches culled by `cullOnGpu` for the `view`th camera.
+    void drawGpuDriven(const Frame& info,
+                       const vk::raii::CommandBuffer& graphicsCmdBuffer,
+                       const core::cameras::Camera& camera,
+                       const FrameAllocator::Allocation& cameraUniforms,
+                       uint32_t view);
     void drawImGui(const Frame& info,
                    const vk::raii::CommandBuffer& graphicsCmdBuffer);
     void presentFrame(const Frame& info);
     void endFrame();
 
-    inline void registerCommandBuffer(uint8_t frameIndex,
-                                      vk::raii::CommandBuffer&& commandBuffer) {
-      submittedCommandBuffers[frameIndex].emplace_back(
-          std::move(commandBuffer));
-    }
-
     inline void checkCompletedCommandBuffers() {
       auto [first, last] = std::ranges::remove_if(
           ongoingCommandBuffers,
@@ -212,16 +337,22 @@ namespace keptech::vkh {
     const core::window::Window* window;
     VulkanCore vkcore;
     vma::Allocator allocator;
+    PipelineCache pipelineCache;
+    PipelineRegistry pipelineRegistry = {};
     ImGuiVkObjects imGuiObjects;
     CameraObjects cameraObjects;
-
-    std::array<std::vector<vk::raii::CommandBuffer>, MAX_FRAMES_IN_FLIGHT>
-        submittedCommandBuffers;
+    FrameAllocator frameAllocator;
+    /// Set when the renderer was created GPU-driven.
+    std::optional<GpuCulling> gpuCulling;
 
     uint8_t nextFrameIndex = 0;
+    FrameStats frameStats = {};
 
     std::vector<OnGoingCmdTransfer> ongoingCommandBuffers = {};
 
+    /// Render objects waiting on `attachMeshBounds`.
+    std::vector<ecs::EntityHandle> pendingBounds = {};
+
     core::SlotMap<vkh::Mesh> loadedMeshes = {};
     core::SlotMap<vkh::Material> loadedMaterials = {};
     std::unordered_map<std::string, core::SlotMapWeakHandle> meshNameMap = {};
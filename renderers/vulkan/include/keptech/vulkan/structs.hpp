@@ -1,6 +1,9 @@
 #pragma once
 
+#include <deque>
 #include <expected>
+#include <functional>
+#include <glm/glm.hpp>
 #include <vk_mem_alloc.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
@@ -21,6 +24,24 @@ namespace keptech::vkh {
   struct CommandPool {
     vk::raii::CommandPool pool;
     Queue queue;
+    /// Command buffers allocated by `acquire`, handed out again after each
+    /// `reset`. Deques keep handed out references valid as they grow.
+    std::deque<vk::raii::CommandBuffer> primaries = {};
+    std::deque<vk::raii::CommandBuffer> secondaries = {};
+    size_t usedPrimaries = 0;
+    size_t usedSecondaries = 0;
+    /// vkAllocateCommandBuffers calls since the last `reset`.
+    uint32_t allocations = 0;
+
+    /// Returns a command buffer of `level` not handed out since the last
+    /// `reset`, only allocating one once every existing buffer is in use.
+    std::expected<std::reference_wrapper<const vk::raii::CommandBuffer>,
+                  std::string>
+    acquire(const vk::raii::Device& device, vk::CommandBufferLevel level);
+
+    /// Resets the pool, returning every command buffer to the initial state
+    /// ready to be acquired again. None may still be pending execution.
+    void reset();
 
     vk::raii::CommandPool& operator*() { return pool; }
     vk::raii::CommandPool* operator->() { return &pool; }
@@ -84,6 +105,18 @@ namespace keptech::vkh {
                         const AllocatedBuffer& allocatedBuffer);
   };
 
+  /// Per-object data read by material shaders through the instance buffer
+  /// address pushed at offset 0, indexed by SV_StartInstanceLocation +
+  /// SV_InstanceID. Mirrors keptech::Instance in shaders/instance.slang.
+  struct InstanceData {
+    glm::mat4 modelMatrix;
+    /// Local bounding sphere as centre and radius. Negative radii are never
+    /// culled.
+    glm::vec4 sphere;
+    vk::DeviceAddress vertexBuffer;
+    uint64_t padding = 0;
+  };
+
   struct OnGoingCmdTransfer {
     vk::raii::CommandBuffer cmdBuffer;
     AllocatedBuffer buffer;
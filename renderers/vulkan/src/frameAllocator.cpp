@@ -0,0 +1,179 @@
+#include "keptech/vulkan/frameAllocator.hpp"
+
+#include "keptech/vulkan/helpers/descriptors.hpp"
+#include "macros.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace keptech::vkh {
+  namespace {
+    vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+      return (value + alignment - 1) & ~(alignment - 1);
+    }
+  } // namespace
+
+  std::expected<FrameAllocator, std::string>
+  FrameAllocator::create(const vk::raii::Device& device,
+                         vma::Allocator& allocator,
+                         const vk::PhysicalDeviceLimits& limits,
+                         const vk::raii::DescriptorSetLayout& uniformLayout,
+                         vk::DeviceSize uniformRange) {
+    vk::DescriptorPoolSize poolSize{
+        .type = vk::DescriptorType::eUniformBufferDynamic,
+        .descriptorCount = MAX_BLOCKS * MAX_FRAMES_IN_FLIGHT,
+    };
+    VK_MAKE(pool,
+            device.createDescriptorPool({
+                .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+                .maxSets = MAX_BLOCKS * MAX_FRAMES_IN_FLIGHT,
+                .poolSizeCount = 1,
+                .pPoolSizes = &poolSize,
+            }),
+            "Failed to create frame allocator descriptor pool");
+
+    vk::DeviceSize uniformAlignment = std::max<vk::DeviceSize>(
+        limits.minUniformBufferOffsetAlignment, ADDRESS_ALIGNMENT);
+
+    return FrameAllocator(allocator, std::move(pool), *uniformLayout,
+                          uniformRange, uniformAlignment);
+  }
+
+  std::expected<void, std::string>
+  FrameAllocator::reset(const vk::raii::Device& device, uint8_t frameIndex) {
+    Frame& frame = frames[frameIndex];
+    frame.current = 0;
+
+    if (frame.blocks.size() <= 1) {
+      for (auto& block : frame.blocks) {
+        block.used = 0;
+      }
+      return {};
+    }
+
+    // The frame outgrew its first block, so replace them all with one that
+    // would have fit everything.
+    vk::DeviceSize total = 0;
+    for (auto& block : frame.blocks) {
+      total += block.size;
+      block.buffer.destroy(allocator);
+    }
+    frame.blocks.clear();
+
+    VKH_MAKE(block, createBlock(device, std::bit_ceil(total)),
+             "Failed to create frame allocator block");
+    frame.blocks.push_back(std::move(block));
+    return {};
+  }
+
+  std::expected<FrameAllocator::Allocation, std::string>
+  FrameAllocator::allocate(const vk::raii::Device& device, uint8_t frameIndex,
+                           vk::DeviceSize size, vk::DeviceSize alignment) {
+    Frame& frame = frames[frameIndex];
+
+    auto allocateFrom = [&](Block& block, vk::DeviceSize offset) {
+      block.used = offset + size;
+      return Allocation{
+          .data = block.buffer.mapping(offset),
+          .buffer = block.buffer.buffer,
+          .offset = offset,
+          .address = block.buffer.address + offset,
+          .uniformSet = *block.uniformSet,
+      };
+    };
+
+    for (; frame.current < frame.blocks.size(); ++frame.current) {
+      Block& block = frame.blocks[frame.current];
+      vk::DeviceSize offset = alignUp(block.used, alignment);
+      if (offset + size <= block.size) {
+        return allocateFrom(block, offset);
+      }
+    }
+
+    if (frame.blocks.size() >= MAX_BLOCKS) {
+      VK_ERROR("Frame allocator ran out of blocks allocating {} bytes", size);
+      return std::unexpected("Frame allocator ran out of blocks");
+    }
+
+    vk::DeviceSize blockSize =
+        frame.blocks.empty() ? MIN_BLOCK_SIZE : frame.blocks.back().size * 2;
+    VKH_MAKE(block,
+             createBlock(device, std::max(blockSize, std::bit_ceil(size))),
+             "Failed to create frame allocator block");
+    frame.blocks.push_back(std::move(block));
+    frame.current = frame.blocks.size() - 1;
+    return allocateFrom(frame.blocks.back(), 0);
+  }
+
+  void FrameAllocator::flush(uint8_t frameIndex) {
+    for (auto& block : frames[frameIndex].blocks) {
+      if (block.used == 0) {
+        continue;
+      }
+
+      auto result =
+          allocator.flushAllocation(block.buffer.alloc, 0, block.used);
+      if (result != vk::Result::eSuccess) {
+        VK_ERROR("Failed to flush frame allocator block: {}",
+                 vk::to_string(result));
+      }
+    }
+  }
+
+  void FrameAllocator::destroy() {
+    for (auto& frame : frames) {
+      for (auto& block : frame.blocks) {
+        block.buffer.destroy(allocator);
+      }
+      frame.blocks.clear();
+    }
+  }
+
+  std::expected<FrameAllocator::Block, std::string>
+  FrameAllocator::createBlock(const vk::raii::Device& device,
+                              vk::DeviceSize size) {
+    VKH_MAKE(buffer,
+             AddressedAllocatedBuffer::create(
+                 device, allocator,
+                 {
+                     .size = size,
+                     .usage = vk::BufferUsageFlagBits::eUniformBuffer |
+                              vk::BufferUsageFlagBits::eStorageBuffer |
+                              vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                     .sharingMode = vk::SharingMode::eExclusive,
+                 },
+                 {
+                     .flags = vma::AllocationCreateFlagBits::eMapped,
+                     .usage = vma::MemoryUsage::eCpuToGpu,
+                 }),
+             "Failed to create frame allocator buffer");
+
+    auto setsRes = device.allocateDescriptorSets({
+        .descriptorPool = *pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &uniformLayout,
+    });
+    if (setsRes.result != vk::Result::eSuccess) {
+      buffer.destroy(allocator);
+      VK_ERROR("Failed to allocate frame allocator descriptor set: {}",
+               vk::to_string(setsRes.result));
+      return std::unexpected(
+          "Failed to allocate frame allocator descriptor set");
+    }
+
+    DescriptorWriter writer;
+    writer.writeBuffer(0,
+                       {
+                           .buffer = buffer.buffer,
+                           .offset = 0,
+                           .range = uniformRange,
+                       },
+                       DescriptorWriter::BufferType::UniformDynamic);
+    writer.update(device, *setsRes.value.front());
+
+    return Block{
+        .buffer = buffer,
+        .size = size,
+        .uniformSet = std::move(setsRes.value.front()),
+    };
+  }
+} // namespace keptech::vkh
@@ -0,0 +1,324 @@
+#include "keptech/vulkan/gpuCulling.hpp"
+
+#include "keptech/vulkan/helpers/descriptors.hpp"
+#include "keptech/vulkan/helpers/shader.hpp"
+#include "macros.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace shaders {
+#include "shaders/cull.h"
+}
+
+namespace keptech::vkh {
+  namespace {
+    /// Mirrors CullConstants in cull.slang.
+    struct CullConstants {
+      std::array<glm::vec4, 6> planes;
+      uint32_t drawCount;
+      uint32_t commandOffset;
+      uint32_t countOffset;
+    };
+
+    constexpr uint32_t BINDING_COUNT = 4;
+
+    static_assert(sizeof(InstanceData) == 96,
+                  "InstanceData must match keptech::Instance");
+    static_assert(sizeof(GpuCulling::Draw) == 32,
+                  "Draw must match Draw in cull.slang");
+    static_assert(sizeof(maths::Plane) == sizeof(glm::vec4),
+                  "Planes are pushed as float4");
+  } // namespace
+
+  std::expected<GpuCulling, std::string>
+  GpuCulling::create(const vk::raii::Device& device, vma::Allocator& allocator,
+                     const PipelineCache& pipelineCache,
+                     uint32_t graphicsFamily, uint32_t computeFamily) {
+    DescriptorLayoutBuilder layoutBuilder;
+    for (uint32_t binding = 0; binding < BINDING_COUNT; ++binding) {
+      layoutBuilder.addBinding(binding, vk::DescriptorType::eStorageBuffer,
+                               vk::ShaderStageFlagBits::eCompute);
+    }
+    VKH_MAKE(layout, layoutBuilder.build(device),
+             "Failed to create culling descriptor layout");
+
+    vk::DescriptorPoolSize poolSize{
+        .type = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount = BINDING_COUNT * MAX_FRAMES_IN_FLIGHT,
+    };
+    VK_MAKE(pool,
+            device.createDescriptorPool({
+                .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+                .maxSets = MAX_FRAMES_IN_FLIGHT,
+                .poolSizeCount = 1,
+                .pPoolSizes = &poolSize,
+            }),
+            "Failed to create culling descriptor pool");
+
+    vk::PushConstantRange pushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = sizeof(CullConstants),
+    };
+    VK_MAKE(pipelineLayout,
+            device.createPipelineLayout({
+                .setLayoutCount = 1,
+                .pSetLayouts = &*layout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &pushConstantRange,
+            }),
+            "Failed to create culling pipeline layout");
+
+    VKH_MAKE(cullShader,
+             Shader::create(device, shaders::cull, shaders::cull_size),
+             "Failed to create culling shader");
+
+    VK_MAKE(pipeline,
+            device.createComputePipeline(
+                *pipelineCache,
+                vk::ComputePipelineCreateInfo{
+                    .stage =
+                        {
+                            .stage = vk::ShaderStageFlagBits::eCompute,
+                            .module = *cullShader.get(),
+                            .pName = "cull",
+                        },
+                    .layout = *pipelineLayout,
+                }),
+            "Failed to create culling pipeline");
+
+    auto createFrame = [&]() -> std::expected<Frame, std::string> {
+      VK_MAKE(descriptorSets,
+              device.allocateDescriptorSets({
+                  .descriptorPool = *pool,
+                  .descriptorSetCount = 1,
+                  .pSetLayouts = &*layout,
+              }),
+              "Failed to allocate culling descriptor set");
+
+      VK_MAKE(semaphore, device.createSemaphore(vk::SemaphoreCreateInfo{}),
+              "Failed to create culling semaphore");
+
+      return Frame{
+          .descriptorSet = std::move(descriptorSets.front()),
+          .cullComplete = std::move(semaphore),
+      };
+    };
+
+    VKH_MAKE(frame1, createFrame(), "Failed to create culling frame");
+    VKH_MAKE(frame2, createFrame(), "Failed to create culling frame");
+
+    std::array<Frame, MAX_FRAMES_IN_FLIGHT> frames = {std::move(frame1),
+                                                      std::move(frame2)};
+
+    return GpuCulling(allocator, std::move(layout), std::move(pool),
+                      std::move(pipelineLayout), std::move(pipeline),
+                      std::move(frames), {graphicsFamily, computeFamily});
+  }
+
+  std::expected<void, std::string>
+  GpuCulling::cull(const vk::raii::Device& device, uint8_t frameIndex,
+                   const vk::raii::CommandBuffer& cmd,
+                   std::span<const maths::Frustum> views) {
+    Frame& frame = frames[frameIndex];
+    culledViews = static_cast<uint32_t>(views.size());
+
+    auto reserved = reserve(device, frame, culledViews);
+    if (!reserved) {
+      return reserved;
+    }
+
+    if (draws.empty() || views.empty()) {
+      return {};
+    }
+
+    vk::DeviceSize instancesSize = instances.size() * sizeof(InstanceData);
+    vk::DeviceSize drawsSize = draws.size() * sizeof(Draw);
+    memcpy(frame.instances.mapping(), instances.data(), instancesSize);
+    memcpy(frame.draws.mapping(), draws.data(), drawsSize);
+
+    // Host visible memory is not always host coherent.
+    for (auto [alloc, size] : {std::pair{frame.instances.alloc, instancesSize},
+                               std::pair{frame.draws.alloc, drawsSize}}) {
+      auto result = allocator.flushAllocation(alloc, 0, size);
+      if (result != vk::Result::eSuccess) {
+        return std::unexpected("Failed to flush culling buffer: " +
+                               vk::to_string(result));
+      }
+    }
+
+    cmd.fillBuffer(frame.counts.buffer, 0,
+                   views.size() * batches.size() * sizeof(uint32_t), 0);
+
+    vk::BufferMemoryBarrier2 countsBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead |
+                         vk::AccessFlagBits2::eShaderStorageWrite,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = frame.counts.buffer,
+        .offset = 0,
+        .size = vk::WholeSize,
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers = &countsBarrier,
+    });
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0,
+                           {*frame.descriptorSet}, {});
+
+    auto drawCount = static_cast<uint32_t>(draws.size());
+    auto batchCount = static_cast<uint32_t>(batches.size());
+    for (uint32_t view = 0; view < culledViews; ++view) {
+      CullConstants constants{
+          .drawCount = drawCount,
+          .commandOffset = view * drawCount,
+          .countOffset = view * batchCount,
+      };
+      for (size_t i = 0; i < constants.planes.size(); ++i) {
+        const auto& plane = views[view].planes[i];
+        constants.planes[i] = glm::vec4(plane.normal, plane.distance);
+      }
+
+      cmd.pushConstants<CullConstants>(
+          pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+      cmd.dispatch((drawCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+    }
+
+    return {};
+  }
+
+  void GpuCulling::drawBatch(uint8_t frameIndex,
+                             const vk::raii::CommandBuffer& cmd, uint32_t view,
+                             uint32_t batch) const {
+    const Frame& frame = frames[frameIndex];
+    const Batch& drawn = batches[batch];
+
+    vk::DeviceSize commandOffset =
+        (view * draws.size() + drawn.commandBase) * COMMAND_STRIDE;
+    vk::DeviceSize countOffset =
+        (view * batches.size() + batch) * sizeof(uint32_t);
+
+    if (drawn.mesh->indexBuffer.has_value()) {
+      cmd.bindIndexBuffer(drawn.mesh->indexBuffer->buffer, 0,
+                          vk::IndexType::eUint32);
+      cmd.drawIndexedIndirectCount(frame.commands.buffer, commandOffset,
+                                   frame.counts.buffer, countOffset,
+                                   drawn.drawCount, COMMAND_STRIDE);
+    } else {
+      cmd.drawIndirectCount(frame.commands.buffer, commandOffset,
+                            frame.counts.buffer, countOffset, drawn.drawCount,
+                            COMMAND_STRIDE);
+    }
+  }
+
+  void GpuCulling::destroy() {
+    for (auto& frame : frames) {
+      frame.instances.destroy(allocator);
+      frame.draws.destroy(allocator);
+      frame.commands.destroy(allocator);
+      frame.counts.destroy(allocator);
+    }
+  }
+
+  std::expected<void, std::string>
+  GpuCulling::reserve(const vk::raii::Device& device, Frame& frame,
+                      uint32_t viewCount) {
+    bool replaced = false;
+    auto grow = [&](AllocatedBuffer& buffer, size_t& capacity, size_t needed,
+                    size_t stride, vk::BufferUsageFlags usage,
+                    bool hostVisible) -> std::expected<void, std::string> {
+      if (needed <= capacity && buffer.buffer) {
+        return {};
+      }
+
+      size_t newCapacity = std::max(std::bit_ceil(needed), MIN_CAPACITY);
+      VKH_MAKE(newBuffer,
+               createBuffer(newCapacity * stride, usage, hostVisible),
+               "Failed to create culling buffer");
+
+      buffer.destroy(allocator);
+      buffer = newBuffer;
+      capacity = newCapacity;
+      replaced = true;
+      return {};
+    };
+
+    constexpr auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+    constexpr auto indirect = vk::BufferUsageFlagBits::eIndirectBuffer;
+
+    std::array<std::expected<void, std::string>, BINDING_COUNT> grown = {
+        grow(frame.instances, frame.instanceCapacity, instances.size(),
+             sizeof(InstanceData),
+             storage | vk::BufferUsageFlagBits::eShaderDeviceAddress, true),
+        grow(frame.draws, frame.drawCapacity, draws.size(), sizeof(Draw),
+             storage, true),
+        grow(frame.commands, frame.commandCapacity, viewCount * draws.size(),
+             COMMAND_STRIDE, storage | indirect, false),
+        grow(frame.counts, frame.countCapacity, viewCount * batches.size(),
+             sizeof(uint32_t),
+             storage | indirect | vk::BufferUsageFlagBits::eTransferDst, false),
+    };
+    for (auto& result : grown) {
+      if (!result) {
+        return result;
+      }
+    }
+
+    if (!replaced) {
+      return {};
+    }
+
+    frame.instances.address =
+        device.getBufferAddress({.buffer = frame.instances.buffer});
+
+    std::array<const AllocatedBuffer*, BINDING_COUNT> buffers = {
+        &frame.instances, &frame.draws, &frame.commands, &frame.counts};
+
+    DescriptorWriter writer;
+    for (uint32_t binding = 0; binding < BINDING_COUNT; ++binding) {
+      writer.writeBuffer(binding,
+                         {
+                             .buffer = buffers[binding]->buffer,
+                             .offset = 0,
+                             .range = vk::WholeSize,
+                         },
+                         DescriptorWriter::BufferType::Storage);
+    }
+    writer.update(device, *frame.descriptorSet);
+
+    return {};
+  }
+
+  std::expected<AllocatedBuffer, std::string>
+  GpuCulling::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+                           bool hostVisible) {
+    bool shared = queueFamilies[0] != queueFamilies[1];
+
+    vma::AllocationCreateInfo allocInfo{.usage = vma::MemoryUsage::eGpuOnly};
+    if (hostVisible) {
+      allocInfo = {
+          .flags = vma::AllocationCreateFlagBits::eMapped,
+          .usage = vma::MemoryUsage::eCpuToGpu,
+      };
+    }
+
+    return AllocatedBuffer::create(
+        allocator,
+        {
+            .size = size,
+            .usage = usage,
+            .sharingMode = shared ? vk::SharingMode::eConcurrent
+                                  : vk::SharingMode::eExclusive,
+            .queueFamilyIndexCount = shared ? 2u : 0u,
+            .pQueueFamilyIndices = shared ? queueFamilies.data() : nullptr,
+        },
+        allocInfo);
+  }
+} // namespace keptech::vkh
@@ -135,8 +135,14 @@ namespace keptech::vkh {
       });
     }
 
+    // Hand built mesh data may not have had its bounds computed.
+    maths::Bounds bounds = meshData.bounds;
+    if (bounds.isEmpty() || meshData.submeshes.empty()) {
+      bounds = core::rendering::computeBounds(vertices, indices, submeshes);
+    }
+
     return std::make_pair(Mesh(meshData.name, vertexBuffer, indexBuffer,
-                               std::move(submeshes), allocator),
+                               std::move(submeshes), bounds, allocator),
                           OnGoingCmdTransfer{.cmdBuffer = std::move(cmdBuffer),
                                              .buffer = stagingBuf,
                                              .fence = std::move(fence)});
@@ -0,0 +1,185 @@
+#include "keptech/vulkan/pipelineCache.hpp"
+
+#include "macros.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <span>
+
+namespace keptech::vkh {
+  namespace {
+    constexpr std::array<char, 4> MAGIC = {'K', 'T', 'P', 'C'};
+    /// Bumped whenever the header layout changes.
+    constexpr uint32_t VERSION = 1;
+
+    /// 64 bit FNV-1a.
+    uint64_t checksum(std::span<const uint8_t> data) {
+      uint64_t hash = 0xcbf29ce484222325;
+      for (uint8_t byte : data) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+      }
+      return hash;
+    }
+
+    /// Whether `data` starts with the header Vulkan itself writes, for the
+    /// device `header` describes.
+    template <typename Header>
+    bool matchesVulkanHeader(std::span<const uint8_t> data,
+                             const Header& header) {
+      vk::PipelineCacheHeaderVersionOne vkHeader;
+      if (data.size() < sizeof(vkHeader)) {
+        return false;
+      }
+      memcpy(&vkHeader, data.data(), sizeof(vkHeader));
+
+      return vkHeader.headerVersion == vk::PipelineCacheHeaderVersion::eOne &&
+             vkHeader.vendorID == header.vendorID &&
+             vkHeader.deviceID == header.deviceID &&
+             std::ranges::equal(vkHeader.pipelineCacheUUID,
+                                header.pipelineCacheUUID);
+    }
+  } // namespace
+
+  std::expected<PipelineCache, std::string>
+  PipelineCache::create(const vk::raii::Device& device,
+                        const vk::raii::PhysicalDevice& physicalDevice,
+                        std::filesystem::path path) {
+    Header header = makeHeader(physicalDevice);
+
+    std::vector<uint8_t> data;
+    if (!path.empty()) {
+      data = load(path, header);
+    }
+
+    VK_MAKE(cache,
+            device.createPipelineCache({
+                .initialDataSize = data.size(),
+                .pInitialData = data.data(),
+            }),
+            "Failed to create pipeline cache");
+
+    if (!data.empty()) {
+      VK_INFO("Loaded {} byte pipeline cache from {}", data.size(),
+              path.string());
+    }
+
+    return PipelineCache(std::move(cache), std::move(path), header);
+  }
+
+  std::expected<void, std::string> PipelineCache::save() const {
+    if (path.empty()) {
+      return {};
+    }
+
+    std::vector<uint8_t> data = cache.getData();
+    Header fileHeader = header;
+    fileHeader.dataSize = data.size();
+    fileHeader.checksum = checksum(data);
+
+    std::error_code error;
+    if (path.has_parent_path()) {
+      std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+      std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(&fileHeader),
+                 sizeof(fileHeader));
+      file.write(reinterpret_cast<const char*>(data.data()),
+                 static_cast<std::streamsize>(data.size()));
+      file.flush();
+      if (!file) {
+        std::filesystem::remove(tempPath, error);
+        VK_ERROR("Failed to write pipeline cache to {}", tempPath.string());
+        return std::unexpected("Failed to write pipeline cache");
+      }
+    }
+
+    // Readers see either the old file or the new one, never a partial write.
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+      VK_ERROR("Failed to replace pipeline cache {}: {}", path.string(),
+               error.message());
+      std::filesystem::remove(tempPath, error);
+      return std::unexpected("Failed to replace pipeline cache");
+    }
+
+    VK_DEBUG("Saved {} byte pipeline cache to {}", data.size(),
+             path.string());
+    return {};
+  }
+
+  PipelineCache::Header
+  PipelineCache::makeHeader(const vk::raii::PhysicalDevice& physicalDevice) {
+    auto properties = physicalDevice.getProperties2<
+        vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+    const auto& deviceProperties =
+        properties.get<vk::PhysicalDeviceProperties2>().properties;
+    const auto& ids = properties.get<vk::PhysicalDeviceIDProperties>();
+
+    Header header{
+        .magic = MAGIC,
+        .version = VERSION,
+        .vendorID = deviceProperties.vendorID,
+        .deviceID = deviceProperties.deviceID,
+        .driverVersion = deviceProperties.driverVersion,
+        .padding = 0,
+        .dataSize = 0,
+        .checksum = 0,
+        .deviceUUID = {},
+        .pipelineCacheUUID = {},
+    };
+    std::ranges::copy(ids.deviceUUID, header.deviceUUID.begin());
+    std::ranges::copy(deviceProperties.pipelineCacheUUID,
+                      header.pipelineCacheUUID.begin());
+    return header;
+  }
+
+  std::vector<uint8_t> PipelineCache::load(const std::filesystem::path& path,
+                                           const Header& expected) {
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error) {
+      return {};
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    Header header{};
+    if (fileSize < sizeof(Header) ||
+        !file.read(reinterpret_cast<char*>(&header), sizeof(Header)) ||
+        header.magic != MAGIC || header.version != VERSION) {
+      VK_WARN("Ignoring pipeline cache {} with an invalid header",
+              path.string());
+      return {};
+    }
+
+    if (header.vendorID != expected.vendorID ||
+        header.deviceID != expected.deviceID ||
+        header.driverVersion != expected.driverVersion ||
+        header.deviceUUID != expected.deviceUUID ||
+        header.pipelineCacheUUID != expected.pipelineCacheUUID) {
+      VK_INFO("Ignoring pipeline cache {} from another device or driver",
+              path.string());
+      return {};
+    }
+
+    if (header.dataSize != fileSize - sizeof(Header)) {
+      VK_WARN("Ignoring truncated pipeline cache {}", path.string());
+      return {};
+    }
+
+    std::vector<uint8_t> data(header.dataSize);
+    if (!file.read(reinterpret_cast<char*>(data.data()),
+                   static_cast<std::streamsize>(data.size())) ||
+        checksum(data) != header.checksum ||
+        !matchesVulkanHeader(data, expected)) {
+      VK_WARN("Ignoring corrupt pipeline cache {}", path.string());
+      return {};
+    }
+
+    return data;
+  }
+} // namespace keptech::vkh
@@ -0,0 +1,40 @@
+#include "keptech/vulkan/pipelineRegistry.hpp"
+
+namespace keptech::vkh {
+  PipelineRegistry::Entry* PipelineRegistry::acquire(const std::string& key) {
+    auto found = ids.find(key);
+    if (found == ids.end()) {
+      return nullptr;
+    }
+
+    Entry& entry = entries.at(found->second);
+    ++entry.refs;
+    return &entry;
+  }
+
+  PipelineRegistry::Entry&
+  PipelineRegistry::insert(std::string key, vk::raii::Pipeline&& pipeline,
+                           vk::raii::PipelineLayout&& layout) {
+    uint32_t id = nextId++;
+    ids.emplace(key, id);
+    auto [entry, inserted] = entries.emplace(
+        id, Entry{
+                .pipeline = std::move(pipeline),
+                .layout = std::move(layout),
+                .id = id,
+                .refs = 1,
+                .key = std::move(key),
+            });
+    return entry->second;
+  }
+
+  void PipelineRegistry::release(uint32_t id) {
+    auto found = entries.find(id);
+    if (found == entries.end() || --found->second.refs > 0) {
+      return;
+    }
+
+    ids.erase(found->second.key);
+    entries.erase(found);
+  }
+} // namespace keptech::vkh
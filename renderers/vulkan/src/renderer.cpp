@@ -7,9 +7,13 @@
 #include <imgui/backends/imgui_impl_vulkan.h>
 #include <imgui/imgui.h>
 #include <keptech/core/cameras/camera.hpp>
+#include <keptech/core/components/bounds.hpp>
+#include <keptech/core/components/spatialIndex.hpp>
+#include <keptech/core/radixSort.hpp>
 #include <keptech/core/renderer.hpp>
 #include <keptech/core/rendering/gltf/loaded.hpp>
 #include <keptech/core/window.hpp>
+#include <bit>
 #include <set>
 
 namespace keptech::vkh {
@@ -128,28 +132,230 @@ namespace keptech::vkh {
         return vk::BlendFactor::eOne;
       }
     }
+
+    /// Identifies a material config by its contents, with formats resolved
+    /// against the swapchain, so configs that would compile to the same
+    /// pipeline share a key.
+    std::string
+    pipelineKey(const core::rendering::PipelineCreateInfo& createInfo,
+                vk::Format swapchainFormat) {
+      std::string key;
+      auto append = [&key](const auto& value) {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+      };
+
+      append(createInfo.shaders.size());
+      for (const auto& shader : createInfo.shaders) {
+        append(shader.size);
+        key.append(reinterpret_cast<const char*>(shader.code), shader.size);
+        append(shader.stages.size());
+        for (const auto& stage : shader.stages) {
+          append(stage.stage);
+          append(stage.name.size());
+          key.append(stage.name);
+        }
+      }
+
+      append(createInfo.attachments.colorFormats.size());
+      for (auto colorFormat : createInfo.attachments.colorFormats) {
+        append(from(colorFormat, swapchainFormat));
+      }
+      append(from(createInfo.attachments.depthFormat, vk::Format::eD16Unorm));
+      append(
+          from(createInfo.attachments.stencilFormat, vk::Format::eUndefined));
+
+      append(createInfo.topology);
+      append(createInfo.rasterizer.polygonMode);
+      append(createInfo.rasterizer.cullMode);
+      append(createInfo.rasterizer.frontFace);
+      append(createInfo.blend.enableBlending);
+      append(createInfo.blend.src);
+      append(createInfo.blend.dst);
+
+      append(createInfo.layout.pushConstantRanges.size());
+      for (const auto& range : createInfo.layout.pushConstantRanges) {
+        append(range.offset);
+        append(range.size);
+        append(range.stages.flags);
+      }
+
+      return key;
+    }
+
+    /// Key render objects are drawn in. Opaque stages group by pipeline and
+    /// then mesh, so neighbours share state, and go front to back within a
+    /// group. Transparent objects have to go back to front, so there depth
+    /// comes first and the rest only breaks ties.
+    uint64_t makeSortKey(Material::Stage stage, uint32_t pipeline,
+                         core::SlotMapHandle mesh, float distanceSq) {
+      constexpr uint64_t ID_MASK = (uint64_t{1} << 20) - 1;
+      constexpr uint64_t DEPTH_MASK = (uint64_t{1} << 22) - 1;
+
+      // Non-negative floats order the same as their bits.
+      uint64_t depth = std::bit_cast<uint32_t>(distanceSq) >> 10;
+      uint64_t pipelineId = pipeline & ID_MASK;
+      uint64_t meshId = mesh & ID_MASK;
+
+      uint64_t key = static_cast<uint64_t>(stage) << 62;
+      if (stage == Material::Stage::Transparent) {
+        return key | ((DEPTH_MASK - depth) << 40) | (pipelineId << 20) |
+               meshId;
+      }
+      return key | (pipelineId << 42) | (meshId << 22) | depth;
+    }
   } // namespace
 
+  std::set<CommandPool*> Renderer::Pools::unique() const {
+    return {graphics.get(), present.get(), compute.get()};
+  }
+
+  std::expected<void, std::string>
+  Renderer::Pools::reserveRecording(const vk::raii::Device& device,
+                                    size_t threads) {
+    recording.reserve(threads);
+    while (recording.size() < threads) {
+      VK_MAKE(pool,
+              device.createCommandPool(vk::CommandPoolCreateInfo{
+                  .flags = vk::CommandPoolCreateFlagBits::eTransient,
+                  .queueFamilyIndex = graphics->queue.index,
+              }),
+              "Failed to create recording command pool");
+      recording.push_back(
+          CommandPool{.pool = std::move(pool), .queue = graphics->queue});
+    }
+    return {};
+  }
+
   void Renderer::Pools::resetAll() {
-    std::set<vk::raii::CommandPool*> unique{
-        &graphics.get()->pool,
-        &present.get()->pool,
-        &compute.get()->pool,
-    };
-    for (auto& pool : unique) {
+    for (auto* pool : unique()) {
       pool->reset();
     }
+    for (auto& pool : recording) {
+      pool.reset();
+    }
+  }
+
+  uint32_t Renderer::Pools::allocationCount() const {
+    uint32_t count = 0;
+    for (const auto* pool : unique()) {
+      count += pool->allocations;
+    }
+    for (const auto& pool : recording) {
+      count += pool.allocations;
+    }
+    return count;
   }
 
   Renderer::ObjectLists
-  Renderer::buildRenderObjectLists(const maths::Frustum& frustum) {
-    ObjectLists lists;
+  Renderer::buildRenderObjectLists(const maths::Frustum& frustum,
+                                   const glm::vec3& eye) {
+    // Visible objects are sorted into lists in chunks of this many.
+    constexpr size_t CHUNK_SIZE = 256;
 
     auto& ecs = ecs::ECS::get();
+    auto& pool = ecs.getThreadPool();
+
+    std::vector<ecs::EntityHandle> visible =
+        ecs.getSystem<components::SpatialIndex>().cull(frustum).entities;
 
-    for (auto& entity : entities) {
-      auto transform = ecs.getComponentRef<components::Transform>(entity);
-      auto renderObj = ecs.getComponentRef<components::RenderObject>(entity);
+    if (visible.empty()) {
+      return {};
+    }
+
+    size_t chunkCount = (visible.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<ObjectLists> perChunk(chunkCount);
+    ecs::JobGroup group;
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+      pool.submit(
+          [&, chunk]() {
+            size_t begin = chunk * CHUNK_SIZE;
+            size_t end = std::min(begin + CHUNK_SIZE, visible.size());
+            auto& lists = perChunk[chunk];
+
+            for (size_t i = begin; i < end; ++i) {
+              // Entities may be in the index for gameplay queries alone.
+              auto* renderObj =
+                  ecs.getComponent<components::RenderObject>(visible[i]);
+              if (!renderObj) {
+                continue;
+              }
+
+              auto meshP = loadedMeshes.get(renderObj->mesh);
+              if (!meshP) {
+                VK_WARN("RenderObject has invalid mesh handle, skipping");
+                continue;
+              }
+
+              auto materialP = loadedMaterials.get(renderObj->material);
+              if (!materialP) {
+                VK_WARN("RenderObject has invalid material handle, skipping");
+                continue;
+              }
+
+              const auto& transform =
+                  ecs.getComponentRef<components::Transform>(visible[i]);
+              glm::vec3 offset = glm::vec3(transform.getWorld()[3]) - eye;
+              VkRenderObject ro{
+                  .transform = transform.getWorld(),
+                  .material = materialP,
+                  .mesh = meshP,
+                  .sortKey = makeSortKey(materialP->stage,
+                                         materialP->pipelineId,
+                                         renderObj->mesh.get(),
+                                         glm::dot(offset, offset)),
+              };
+
+              switch (ro.material->stage) {
+              case Material::Stage::Deferred:
+                lists.deferred.push_back(ro);
+                break;
+              case Material::Stage::Forward:
+                lists.forward.push_back(ro);
+                break;
+              case Material::Stage::Transparent:
+                lists.transparent.push_back(ro);
+                break;
+              }
+            }
+          },
+          group);
+    }
+    pool.wait(group);
+
+    ObjectLists lists = std::move(perChunk.front());
+    for (size_t i = 1; i < perChunk.size(); ++i) {
+      auto append = [](std::vector<VkRenderObject>& dst,
+                       const std::vector<VkRenderObject>& src) {
+        dst.insert(dst.end(), src.begin(), src.end());
+      };
+      append(lists.deferred, perChunk[i].deferred);
+      append(lists.forward, perChunk[i].forward);
+      append(lists.transparent, perChunk[i].transparent);
+    }
+
+    for (auto* list : {&lists.deferred, &lists.forward, &lists.transparent}) {
+      core::radixSort(*list, &VkRenderObject::sortKey);
+    }
+    return lists;
+  }
+
+  void Renderer::buildGpuScene() {
+    auto& ecs = ecs::ECS::get();
+    auto& culling = *gpuCulling;
+    culling.clear();
+
+    struct Entry {
+      const Material* material;
+      const Mesh* mesh;
+      uint32_t instance;
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(entities.size());
+    culling.instances.reserve(entities.size());
+    for (auto entity : entities) {
+      const auto& renderObj =
+          ecs.getComponentRef<components::RenderObject>(entity);
 
       auto meshP = loadedMeshes.get(renderObj.mesh);
       if (!meshP) {
@@ -163,32 +369,142 @@ namespace keptech::vkh {
         continue;
       }
 
-      auto& mesh = *meshP;
-      auto& material = *materialP;
-
-      transform.recalculateGlobalTransform();
+      // Only the forward pass is drawn so far.
+      if (materialP->stage != Material::Stage::Forward) {
+        continue;
+      }
 
-      // TODO: Frustum cull
+      const auto* bounds = ecs.getComponent<components::Bounds>(entity);
+      const maths::Bounds& local = bounds ? bounds->local : meshP->bounds;
+      glm::vec4 sphere =
+          local.isEmpty()
+              ? glm::vec4(0.0f, 0.0f, 0.0f, -1.0f)
+              : glm::vec4(local.sphere.center, local.sphere.radius);
+
+      entries.push_back({
+          .material = materialP,
+          .mesh = meshP,
+          .instance = static_cast<uint32_t>(culling.instances.size()),
+      });
+      culling.instances.push_back({
+          .modelMatrix =
+              ecs.getComponentRef<components::Transform>(entity).getWorld(),
+          .sphere = sphere,
+          .vertexBuffer = meshP->vertexBuffer.address,
+      });
+    }
 
-      struct VkRenderObject ro{
-          .transform = transform.global,
-          .material = &material,
-          .mesh = &mesh,
-      };
+    std::ranges::sort(entries, [](const Entry& lhs, const Entry& rhs) {
+      if (lhs.material->pipelineId != rhs.material->pipelineId) {
+        return lhs.material->pipelineId < rhs.material->pipelineId;
+      }
+      return std::less<>()(lhs.mesh, rhs.mesh);
+    });
+
+    for (const auto& entry : entries) {
+      if (culling.batches.empty() ||
+          culling.batches.back().material->pipeline !=
+              entry.material->pipeline ||
+          culling.batches.back().mesh != entry.mesh) {
+        culling.batches.push_back({
+            .material = entry.material,
+            .mesh = entry.mesh,
+            .commandBase = static_cast<uint32_t>(culling.draws.size()),
+            .drawCount = 0,
+        });
+      }
 
-      switch (material.stage) {
-      case Material::Stage::Deferred:
-        lists.deferred.push_back(ro);
-        break;
-      case Material::Stage::Forward:
-        lists.forward.push_back(ro);
-        break;
-      case Material::Stage::Transparent:
-        lists.transparent.push_back(ro);
-        break;
+      auto& batch = culling.batches.back();
+      bool indexed = entry.mesh->indexBuffer.has_value();
+      for (const auto& submesh : entry.mesh->submeshes) {
+        culling.draws.push_back({
+            .instance = entry.instance,
+            .batch = static_cast<uint32_t>(culling.batches.size() - 1),
+            .commandBase = batch.commandBase,
+            .indexed = indexed ? 1u : 0u,
+            .count = submesh.indexCount,
+            .first = indexed ? submesh.indexOffset : 0,
+        });
+        ++batch.drawCount;
       }
     }
-    return lists;
+  }
+
+  void Renderer::cullOnGpu(const Frame& info) {
+    buildGpuScene();
+
+    std::vector<maths::Frustum> views;
+    for (auto [entity, camera] :
+         ecs::ECS::get().view<core::cameras::Camera>()) {
+      camera.recalculate();
+      views.push_back(maths::Frustum::fromViewProjectionMatrix(
+          camera.getUniforms().viewProjection));
+    }
+
+    auto computeCmdBufferRes = info.pools.get().compute->acquire(
+        vkcore.device.logical, vk::CommandBufferLevel::ePrimary);
+    if (!computeCmdBufferRes) {
+      VK_CRITICAL("Failed to acquire compute command buffer: {}",
+                  computeCmdBufferRes.error());
+      abort();
+    }
+    const vk::raii::CommandBuffer& computeCmdBuffer =
+        computeCmdBufferRes->get();
+
+    computeCmdBuffer.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+    auto culled = gpuCulling->cull(vkcore.device.logical, info.index,
+                                   computeCmdBuffer, views);
+    if (!culled) {
+      VK_CRITICAL("Failed to record GPU culling: {}", culled.error());
+      abort();
+    }
+
+    computeCmdBuffer.end();
+
+    vk::CommandBufferSubmitInfo commandBufferSubmitInfo{
+        .commandBuffer = computeCmdBuffer, .deviceMask = 0};
+
+    vk::SemaphoreSubmitInfo signalSemaphoreSubmitInfo{
+        .semaphore = *gpuCulling->getSemaphore(info.index),
+        .stageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .deviceIndex = 0,
+    };
+
+    vk::SubmitInfo2 computeSubmitInfo{
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &commandBufferSubmitInfo,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos = &signalSemaphoreSubmitInfo,
+    };
+
+    auto result = vkcore.queues.compute.queue->submit2(computeSubmitInfo);
+    if (result != vk::Result::eSuccess) {
+      VK_CRITICAL("Failed to submit compute command buffer: {}",
+                  vk::to_string(result));
+      abort();
+    }
+  }
+
+  void Renderer::attachMeshBounds() {
+    auto& ecs = ecs::ECS::get();
+    std::erase_if(pendingBounds, [&](ecs::EntityHandle entity) {
+      auto* renderObj = ecs.getComponent<components::RenderObject>(entity);
+      if (!renderObj || ecs.hasComponent<components::Bounds>(entity)) {
+        return true;
+      }
+
+      auto meshP = loadedMeshes.get(renderObj->mesh);
+      if (!meshP) {
+        return false;
+      }
+
+      ecs.addComponent(entity, components::Bounds{.local = meshP->bounds});
+      return true;
+    });
+
+    ecs.getSystem<components::SpatialIndex>().updateStatic();
   }
 
   void Renderer::newFrame() {
@@ -233,7 +549,13 @@ namespace keptech::vkh {
     };
 
     frameInfo.pools.get().resetAll();
-    submittedCommandBuffers[nextFrameIndex].clear();
+
+    auto frameReset =
+        frameAllocator.reset(vkcore.device.logical, nextFrameIndex);
+    if (!frameReset) {
+      VK_CRITICAL("Failed to reset frame allocator: {}", frameReset.error());
+      abort();
+    }
 
     this->nextFrameIndex = (this->nextFrameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -242,8 +564,7 @@ namespace keptech::vkh {
 
   void Renderer::setupGraphicsCommandBuffer(
       const Frame& info, const vk::raii::CommandBuffer& graphicsCmdBuffer,
-      const core::cameras::Camera& camera) {
-
+      const core::cameras::Camera& camera) const {
     auto& viewport = camera.getViewport();
     auto& scissor = camera.getScissor();
 
@@ -303,11 +624,19 @@ namespace keptech::vkh {
 
     checkCompletedCommandBuffers();
 
+    auto saved = pipelineCache.save();
+    if (!saved) {
+      VK_WARN("Failed to save pipeline cache: {}", saved.error());
+    }
+
     loadedMeshes.reset();
     loadedMaterials.reset();
+    pipelineRegistry.clear();
 
-    cameraObjects.descriptorSet.release(); // The pool destructor will free this
-    cameraObjects.uniformBuffer.destroy(allocator);
+    frameAllocator.destroy();
+    if (gpuCulling) {
+      gpuCulling->destroy();
+    }
 
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplSDL3_Shutdown();
@@ -449,13 +778,41 @@ namespace keptech::vkh {
 
   std::expected<Renderer::MaterialHandle, std::string>
   Renderer::createMaterial(const Material::CreateInfo& createInfo) {
+    std::string key =
+        pipelineKey(createInfo.pipelineConfig, getSwapchainImageFormat());
+
+    PipelineRegistry::Entry* entry = pipelineRegistry.acquire(key);
+    if (!entry) {
+      VKH_MAKE(created, createPipeline(createInfo.pipelineConfig),
+               "Failed to create material pipeline");
+      entry = &pipelineRegistry.insert(std::move(key),
+                                       std::move(created.first),
+                                       std::move(created.second));
+    }
+
+    Material mat{
+        .pipeline = *entry->pipeline,
+        .pipelineLayout = *entry->layout,
+        .pipelineId = entry->id,
+    };
+    mat.stage = createInfo.stage;
+
+    auto handle = loadedMaterials.emplace(std::move(mat));
+    return MaterialHandle(handle,
+                          [this, handle]() { destroyMaterial(handle); });
+  }
+
+  std::expected<std::pair<vk::raii::Pipeline, vk::raii::PipelineLayout>,
+                std::string>
+  Renderer::createPipeline(
+      const core::rendering::PipelineCreateInfo& createInfo) {
     GraphicsPipelineConfig config;
 
     std::vector<Shader> shaderModules;
 
     std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
 
-    for (auto& shaderInfo : createInfo.pipelineConfig.shaders) {
+    for (auto& shaderInfo : createInfo.shaders) {
       VKH_MAKE(shaderModule,
                Shader::create(vkcore.device.logical, shaderInfo.code,
                               shaderInfo.size),
@@ -479,13 +836,13 @@ namespace keptech::vkh {
     config.shaders = shaderStages;
 
     for (auto& colorFormat :
-         createInfo.pipelineConfig.attachments.colorFormats) {
+         createInfo.attachments.colorFormats) {
       config.rendering.colorAttachmentFormats.push_back(
           from(colorFormat, getSwapchainImageFormat()));
       config.blendAttachments.push_back(vk::PipelineColorBlendAttachmentState{
-          .blendEnable = createInfo.pipelineConfig.blend.enableBlending,
-          .srcColorBlendFactor = from(createInfo.pipelineConfig.blend.src),
-          .dstColorBlendFactor = from(createInfo.pipelineConfig.blend.dst),
+          .blendEnable = createInfo.blend.enableBlending,
+          .srcColorBlendFactor = from(createInfo.blend.src),
+          .dstColorBlendFactor = from(createInfo.blend.dst),
           .colorWriteMask =
               vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
               vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
@@ -493,26 +850,26 @@ namespace keptech::vkh {
     }
 
     config.rendering.depthAttachmentFormat =
-        from(createInfo.pipelineConfig.attachments.depthFormat,
+        from(createInfo.attachments.depthFormat,
              vk::Format::eD16Unorm);
     config.rendering.stencilAttachmentFormat =
-        from(createInfo.pipelineConfig.attachments.stencilFormat,
+        from(createInfo.attachments.stencilFormat,
              vk::Format::eUndefined);
 
     // Input Assembly
-    config.inputAssembly.topology = from(createInfo.pipelineConfig.topology);
+    config.inputAssembly.topology = from(createInfo.topology);
 
     // Rasterizer
     config.rasterizer.polygonMode =
-        from(createInfo.pipelineConfig.rasterizer.polygonMode);
+        from(createInfo.rasterizer.polygonMode);
     config.rasterizer.cullMode =
-        from(createInfo.pipelineConfig.rasterizer.cullMode);
+        from(createInfo.rasterizer.cullMode);
     config.rasterizer.frontFace =
-        from(createInfo.pipelineConfig.rasterizer.frontFace);
+        from(createInfo.rasterizer.frontFace);
 
     // Layout
     for (auto& pushConstant :
-         createInfo.pipelineConfig.layout.pushConstantRanges) {
+         createInfo.layout.pushConstantRanges) {
       vk::PushConstantRange range{
           .stageFlags = from(pushConstant.stages),
           .offset = pushConstant.offset,
@@ -534,17 +891,18 @@ namespace keptech::vkh {
     vkConfig.layout = *pipelineLayout;
 
     VK_MAKE(pipeline,
-            vkcore.device.logical.createGraphicsPipeline(nullptr, vkConfig),
+            vkcore.device.logical.createGraphicsPipeline(*pipelineCache,
+                                                         vkConfig),
             "Failed to create graphics pipeline");
 
-    Material mat{
-        .pipeline = std::move(pipeline),
-        .pipelineLayout = std::move(pipelineLayout),
-    };
-    mat.stage = createInfo.stage;
+    return std::pair{std::move(pipeline), std::move(pipelineLayout)};
+  }
 
-    auto handle = loadedMaterials.emplace(std::move(mat));
-    return MaterialHandle(handle, loadedMaterials);
+  void Renderer::destroyMaterial(core::SlotMapHandle handle) {
+    auto material = loadedMaterials.erase(handle);
+    if (material) {
+      pipelineRegistry.release(material->pipelineId);
+    }
   }
 
   std::expected<Shader, std::string>
@@ -18,50 +18,20 @@ namespace keptech::vkh {
         .clearValue = {
             .color = {std::array<float, 4>{0.1f, 0.1f, 0.1f, 1.0f}}}};
 
-    auto& cameras = ecs::ECS::get().getAllComponents<core::cameras::Camera>();
-    for (auto& camera : cameras) {
+    uint32_t view = 0;
+    for (auto [entity, camera] :
+         ecs::ECS::get().view<core::cameras::Camera>()) {
       camera.recalculate();
       auto uniforms = camera.getUniforms();
 
-      {
-        vk::BufferMemoryBarrier2 cameraBufferBarrier{
-            .srcStageMask = vk::PipelineStageFlagBits2::eVertexShader,
-            .srcAccessMask = vk::AccessFlagBits2::eShaderRead,
-            .dstStageMask = vk::PipelineStageFlagBits2::eHost,
-            .dstAccessMask = vk::AccessFlagBits2::eHostWrite,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = cameraObjects.uniformBuffer.buffer,
-            .offset = 0,
-            .size = sizeof(core::cameras::Uniforms),
-        };
-
-        graphicsCmdBuffer.pipelineBarrier2(vk::DependencyInfo{
-            .bufferMemoryBarrierCount = 1,
-            .pBufferMemoryBarriers = &cameraBufferBarrier,
-        });
-      }
-
-      memcpy(cameraObjects.uniformBuffer.mapping(), &uniforms,
-             sizeof(core::cameras::Uniforms));
-
-      {
-        vk::BufferMemoryBarrier2 cameraBufferBarrier{
-            .srcStageMask = vk::PipelineStageFlagBits2::eHost,
-            .srcAccessMask = vk::AccessFlagBits2::eHostWrite,
-            .dstStageMask = vk::PipelineStageFlagBits2::eVertexShader,
-            .dstAccessMask = vk::AccessFlagBits2::eShaderRead,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = cameraObjects.uniformBuffer.buffer,
-            .offset = 0,
-            .size = sizeof(core::cameras::Uniforms),
-        };
-
-        graphicsCmdBuffer.pipelineBarrier2(vk::DependencyInfo{
-            .bufferMemoryBarrierCount = 1,
-            .pBufferMemoryBarriers = &cameraBufferBarrier,
-        });
+      // Each camera gets its own copy of the uniforms in memory this frame
+      // owns, so nothing recorded earlier is overwritten.
+      auto cameraUniforms =
+          frameAllocator.uniform(vkcore.device.logical, info.index, uniforms);
+      if (!cameraUniforms) {
+        VK_CRITICAL("Failed to allocate camera uniforms: {}",
+                    cameraUniforms.error());
+        abort();
       }
 
       vk::RenderingInfo renderingInfo{
@@ -75,72 +45,298 @@ namespace keptech::vkh {
           .pColorAttachments = &aInfo,
       };
 
+      if (gpuCulling) {
+        graphicsCmdBuffer.beginRendering(renderingInfo);
+        drawGpuDriven(info, graphicsCmdBuffer, camera, *cameraUniforms,
+                      view++);
+        graphicsCmdBuffer.endRendering();
+      } else {
+        drawForward(
+            info, graphicsCmdBuffer, renderingInfo, camera, *cameraUniforms,
+            maths::Frustum::fromViewProjectionMatrix(uniforms.viewProjection));
+      }
+    }
+  }
+
+  void Renderer::bindCamera(const vk::raii::CommandBuffer& graphicsCmdBuffer,
+                            vk::PipelineLayout layout,
+                            const FrameAllocator::Allocation& cameraUniforms)
+      const {
+    uint32_t dynamicOffset = cameraUniforms.dynamicOffset();
+    graphicsCmdBuffer.bindDescriptorSets2({
+        .stageFlags = vk::ShaderStageFlagBits::eVertex |
+                      vk::ShaderStageFlagBits::eFragment,
+        .layout = layout,
+        .firstSet = 0,
+        .descriptorSetCount = 1,
+        .pDescriptorSets = &cameraUniforms.uniformSet,
+        .dynamicOffsetCount = 1,
+        .pDynamicOffsets = &dynamicOffset,
+    });
+  }
+
+  void Renderer::drawForward(const Frame& info,
+                             const vk::raii::CommandBuffer& graphicsCmdBuffer,
+                             const vk::RenderingInfo& renderingInfo,
+                             const core::cameras::Camera& camera,
+                             const FrameAllocator::Allocation& cameraUniforms,
+                             const maths::Frustum& frustum) {
+    // Below this many objects a chunk is not worth a job and a secondary
+    // command buffer of its own.
+    constexpr size_t MIN_CHUNK_SIZE = 2048;
+
+    auto objLists = buildRenderObjectLists(
+        frustum, glm::vec3(camera.getUniforms().inverseView[3]));
+    auto& objects = objLists.forward;
+
+    // Instances are uploaded in list order, so each run of objects sharing a
+    // pipeline and mesh is one contiguous range drawn by a single call.
+    std::vector<InstanceData> instances;
+    instances.reserve(objects.size());
+    for (const auto& renderObject : objects) {
+      const maths::Bounds& bounds = renderObject.mesh->bounds;
+      instances.push_back({
+          .modelMatrix = renderObject.transform,
+          .sphere = bounds.isEmpty() ? glm::vec4(0.0f, 0.0f, 0.0f, -1.0f)
+                                     : glm::vec4(bounds.sphere.center,
+                                                 bounds.sphere.radius),
+          .vertexBuffer = renderObject.mesh->vertexBuffer.address,
+      });
+    }
+
+    vk::DeviceAddress instanceAddress = 0;
+    if (!instances.empty()) {
+      auto uploaded = frameAllocator.upload<InstanceData>(
+          vkcore.device.logical, info.index, instances);
+      if (!uploaded) {
+        VK_CRITICAL("Failed to upload instances: {}", uploaded.error());
+        abort();
+      }
+      instanceAddress = uploaded->address;
+    }
+
+    auto& threadPool = ecs::ECS::get().getThreadPool();
+    size_t concurrency = threadPool.getConcurrency();
+    size_t chunkSize = std::max(
+        MIN_CHUNK_SIZE, (objects.size() + concurrency - 1) / concurrency);
+    size_t chunkCount = (objects.size() + chunkSize - 1) / chunkSize;
+
+    if (chunkCount <= 1) {
       graphicsCmdBuffer.beginRendering(renderingInfo);
+      recordObjects(info, graphicsCmdBuffer, camera, cameraUniforms, objects,
+                    instanceAddress, 0, frameStats);
+      graphicsCmdBuffer.endRendering();
+      return;
+    }
 
-      auto objLists = buildRenderObjectLists(maths::Frustum{});
+    auto reserved =
+        info.pools.get().reserveRecording(vkcore.device.logical, concurrency);
+    if (!reserved) {
+      VK_CRITICAL("Failed to create recording command pools: {}",
+                  reserved.error());
+      abort();
+    }
 
-      for (auto& renderObject : objLists.forward) {
-        auto& material = *renderObject.material;
-        auto& mesh = *renderObject.mesh;
+    vk::Format colorFormat = getSwapchainImageFormat();
+    vk::CommandBufferInheritanceRenderingInfo renderingInheritance{
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &colorFormat,
+        .rasterizationSamples = vk::SampleCountFlagBits::e1,
+    };
+    vk::CommandBufferInheritanceInfo inheritance{
+        .pNext = &renderingInheritance,
+    };
 
-        graphicsCmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
-                                       material.pipeline);
+    // Each job records into a pool only its own thread uses, and keeps its
+    // own stats, so the jobs share nothing they write.
+    std::vector<vk::CommandBuffer> secondaries(chunkCount);
+    std::vector<FrameStats> chunkStats(chunkCount);
+    ecs::JobGroup group;
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+      threadPool.submit(
+          [&, chunk]() {
+            auto& pool = info.pools.get().recording[threadPool.threadIndex()];
+            auto cmdRes =
+                pool.acquire(vkcore.device.logical,
+                             vk::CommandBufferLevel::eSecondary);
+            if (!cmdRes) {
+              VK_CRITICAL("Failed to acquire secondary command buffer: {}",
+                          cmdRes.error());
+              abort();
+            }
+            const vk::raii::CommandBuffer& cmd = cmdRes->get();
+
+            cmd.begin(vk::CommandBufferBeginInfo{
+                .flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue |
+                         vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+                .pInheritanceInfo = &inheritance,
+            });
+
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(begin + chunkSize, objects.size());
+            recordObjects(info, cmd, camera, cameraUniforms,
+                          std::span(objects).subspan(begin, end - begin),
+                          instanceAddress, static_cast<uint32_t>(begin),
+                          chunkStats[chunk]);
+
+            cmd.end();
+            secondaries[chunk] = *cmd;
+          },
+          group);
+    }
+    threadPool.wait(group);
+
+    vk::RenderingInfo secondaryRenderingInfo = renderingInfo;
+    secondaryRenderingInfo.flags =
+        vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+    graphicsCmdBuffer.beginRendering(secondaryRenderingInfo);
+    graphicsCmdBuffer.executeCommands(secondaries);
+    graphicsCmdBuffer.endRendering();
+
+    for (const auto& stats : chunkStats) {
+      frameStats += stats;
+    }
+  }
+
+  void Renderer::recordObjects(const Frame& info,
+                               const vk::raii::CommandBuffer& cmd,
+                               const core::cameras::Camera& camera,
+                               const FrameAllocator::Allocation& cameraUniforms,
+                               std::span<const VkRenderObject> objects,
+                               vk::DeviceAddress instanceAddress,
+                               uint32_t firstInstance,
+                               FrameStats& stats) const {
+    if (objects.empty()) {
+      return;
+    }
+
+    struct PushConstantData {
+      vk::DeviceAddress instanceBufferAddress;
+    } pushConstantData{
+        .instanceBufferAddress = instanceAddress,
+    };
+
+    // The list is sorted so neighbours tend to share state, which is only
+    // set again when it changes. Viewport and scissor are dynamic state and
+    // survive pipeline binds, so they are set once.
+    setupGraphicsCommandBuffer(info, cmd, camera);
+    stats.viewports.record(true);
+
+    vk::Pipeline boundPipeline = nullptr;
+    vk::Buffer boundIndexBuffer = nullptr;
+    for (size_t runStart = 0; runStart < objects.size();) {
+      auto& material = *objects[runStart].material;
+      auto& mesh = *objects[runStart].mesh;
+
+      size_t runEnd = runStart + 1;
+      while (runEnd < objects.size() &&
+             objects[runEnd].material->pipeline == material.pipeline &&
+             objects[runEnd].mesh == &mesh) {
+        ++runEnd;
+      }
+      auto instanceCount = static_cast<uint32_t>(runEnd - runStart);
+      auto runFirst = firstInstance + static_cast<uint32_t>(runStart);
+      runStart = runEnd;
+
+      bool newPipeline = material.pipeline != boundPipeline;
+      stats.pipelineBinds.record(newPipeline);
+      stats.descriptorSetBinds.record(newPipeline);
+      stats.pushConstants.record(newPipeline);
+      if (newPipeline) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, material.pipeline);
+
+        bindCamera(cmd, material.pipelineLayout, cameraUniforms);
+
+        // Push constants may not carry over to a different layout.
+        cmd.pushConstants<PushConstantData>(material.pipelineLayout,
+                                            vk::ShaderStageFlagBits::eVertex,
+                                            0, pushConstantData);
 
-        setupGraphicsCommandBuffer(info, graphicsCmdBuffer, camera);
+        boundPipeline = material.pipeline;
+      }
+
+      for (const auto& submesh : mesh.submeshes) {
+        if (mesh.indexBuffer.has_value()) {
+          bool newIndexBuffer = mesh.indexBuffer->buffer != boundIndexBuffer;
+          stats.indexBufferBinds.record(newIndexBuffer);
+          if (newIndexBuffer) {
+            cmd.bindIndexBuffer(mesh.indexBuffer->buffer, 0,
+                                vk::IndexType::eUint32);
+            boundIndexBuffer = mesh.indexBuffer->buffer;
+          }
+          cmd.drawIndexed(submesh.indexCount, instanceCount,
+                          submesh.indexOffset, 0, runFirst);
+        } else {
+          cmd.draw(submesh.indexCount, instanceCount, 0, runFirst);
+        }
+        ++stats.draws;
+      }
+      stats.instances += instanceCount;
+    }
+  }
 
-        graphicsCmdBuffer.bindDescriptorSets2({
-            .stageFlags = vk::ShaderStageFlagBits::eVertex |
-                          vk::ShaderStageFlagBits::eFragment,
-            .layout = material.pipelineLayout,
-            .firstSet = 0,
-            .descriptorSetCount = 1,
-            .pDescriptorSets = &*cameraObjects.descriptorSet,
-        });
+  void Renderer::drawGpuDriven(
+      const Frame& info, const vk::raii::CommandBuffer& graphicsCmdBuffer,
+      const core::cameras::Camera& camera,
+      const FrameAllocator::Allocation& cameraUniforms, uint32_t view) {
+    if (view >= gpuCulling->viewCount()) {
+      return;
+    }
 
-        struct PushConstantData {
-          vk::DeviceAddress vertexBufferAddress;
-        } pushConstantData{
-            .vertexBufferAddress = mesh.vertexBuffer.address,
-        };
+    setupGraphicsCommandBuffer(info, graphicsCmdBuffer, camera);
+
+    struct PushConstantData {
+      vk::DeviceAddress instanceBufferAddress;
+    } pushConstantData{
+        .instanceBufferAddress = gpuCulling->instanceAddress(info.index),
+    };
+
+    // Batches are sorted by pipeline, so each is bound once.
+    vk::Pipeline bound = nullptr;
+    auto batchCount = static_cast<uint32_t>(gpuCulling->batches.size());
+    for (uint32_t batch = 0; batch < batchCount; ++batch) {
+      const Material& material = *gpuCulling->batches[batch].material;
+      bool newPipeline = material.pipeline != bound;
+      frameStats.pipelineBinds.record(newPipeline);
+      frameStats.descriptorSetBinds.record(newPipeline);
+      frameStats.pushConstants.record(newPipeline);
+      if (newPipeline) {
+        graphicsCmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                       material.pipeline);
+
+        bindCamera(graphicsCmdBuffer, material.pipelineLayout, cameraUniforms);
 
         graphicsCmdBuffer.pushConstants<PushConstantData>(
             material.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0,
             pushConstantData);
 
-        for (const auto& submesh : mesh.submeshes) {
-          if (mesh.indexBuffer.has_value()) {
-            graphicsCmdBuffer.bindIndexBuffer(mesh.indexBuffer->buffer, 0,
-                                              vk::IndexType::eUint32);
-            graphicsCmdBuffer.drawIndexed(submesh.indexCount, 1,
-                                          submesh.indexOffset, 0, 0);
-          } else {
-            graphicsCmdBuffer.draw(submesh.indexCount, 1, 0, 0);
-          }
-        }
+        bound = material.pipeline;
       }
 
-      graphicsCmdBuffer.endRendering();
+      gpuCulling->drawBatch(info.index, graphicsCmdBuffer, view, batch);
+      ++frameStats.draws;
     }
   }
 
   void Renderer::render() {
+    attachMeshBounds();
+    frameStats = {};
+
     Frame info = startFrame();
 
-    vk::CommandBufferAllocateInfo cmdBufAllocInfo{
-        .commandPool =
-            *vkcore.frameResources[info.index].pools.graphics.get()->pool,
-        .level = vk::CommandBufferLevel::ePrimary,
-        .commandBufferCount = 1,
-    };
-    auto graphicsCmdBuffers_res =
-        vkcore.device->allocateCommandBuffers(cmdBufAllocInfo);
-    if (!graphicsCmdBuffers_res.has_value()) {
-      VK_CRITICAL("Failed to allocate graphics command buffer: {}",
-                  vk::to_string(graphicsCmdBuffers_res.result));
+    if (gpuCulling) {
+      cullOnGpu(info);
+    }
+
+    auto graphicsCmdBufferRes = info.pools.get().graphics->acquire(
+        vkcore.device.logical, vk::CommandBufferLevel::ePrimary);
+    if (!graphicsCmdBufferRes) {
+      VK_CRITICAL("Failed to acquire graphics command buffer: {}",
+                  graphicsCmdBufferRes.error());
       abort();
     }
-    vk::raii::CommandBuffer graphicsCmdBuffer =
-        std::move(graphicsCmdBuffers_res.value.front());
+    const vk::raii::CommandBuffer& graphicsCmdBuffer =
+        graphicsCmdBufferRes->get();
 
     graphicsCmdBuffer.begin(vk::CommandBufferBeginInfo{
         .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
@@ -203,11 +399,21 @@ namespace keptech::vkh {
 
     graphicsCmdBuffer.end();
 
-    vk::SemaphoreSubmitInfo waitSemaphoreSubmitInfo{
-        .semaphore = *info.syncObjects.get().presentCompleteSemaphore,
-        .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-        .deviceIndex = 0,
-    };
+    frameAllocator.flush(info.index);
+
+    std::array<vk::SemaphoreSubmitInfo, 2> waitSemaphoreSubmitInfos{{
+        {
+            .semaphore = *info.syncObjects.get().presentCompleteSemaphore,
+            .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            .deviceIndex = 0,
+        },
+        {
+            .semaphore = gpuCulling ? *gpuCulling->getSemaphore(info.index)
+                                    : vk::Semaphore{},
+            .stageMask = vk::PipelineStageFlagBits2::eDrawIndirect,
+            .deviceIndex = 0,
+        },
+    }};
 
     vk::CommandBufferSubmitInfo commandBufferSubmitInfo{
         .commandBuffer = graphicsCmdBuffer, .deviceMask = 0};
@@ -219,8 +425,8 @@ namespace keptech::vkh {
     };
 
     vk::SubmitInfo2 graphicsSubmitInfo{
-        .waitSemaphoreInfoCount = 1,
-        .pWaitSemaphoreInfos = &waitSemaphoreSubmitInfo,
+        .waitSemaphoreInfoCount = gpuCulling ? 2u : 1u,
+        .pWaitSemaphoreInfos = waitSemaphoreSubmitInfos.data(),
         .commandBufferInfoCount = 1,
         .pCommandBufferInfos = &commandBufferSubmitInfo,
         .signalSemaphoreInfoCount = 1,
@@ -235,7 +441,7 @@ namespace keptech::vkh {
       abort();
     }
 
-    registerCommandBuffer(info.index, std::move(graphicsCmdBuffer));
+    frameStats.commandBufferAllocations = info.pools.get().allocationCount();
 
     presentFrame(info);
 
@@ -150,7 +150,7 @@ namespace keptech::vkh::setup {
 
   std::expected<vk::raii::Device, std::string>
   createDevice(vk::raii::PhysicalDevice& physDevice,
-               const std::set<uint32_t>& uniqueQueueFamilies) {
+               const std::set<uint32_t>& uniqueQueueFamilies, bool gpuDriven) {
 
     constexpr float priority = 1.f;
 
@@ -164,7 +164,7 @@ namespace keptech::vkh::setup {
       });
     }
 
-    const vk::StructureChain<
+    vk::StructureChain<
         vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features,
         vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features,
         vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>
@@ -180,9 +180,20 @@ namespace keptech::vkh::setup {
                                     },
                                     {.extendedDynamicState = true}};
 
+    // Instance data holds a 64 bit vertex buffer address.
+    auto& features =
+        ENGINE_DEVICE_EXTENSIONS.get<vk::PhysicalDeviceFeatures2>().features;
+    features.shaderInt64 = true;
+
+    if (gpuDriven) {
+      // Indirect draws select their instance through firstInstance.
+      features.drawIndirectFirstInstance = true;
+      ENGINE_DEVICE_EXTENSIONS.get<vk::PhysicalDeviceVulkan12Features>()
+          .drawIndirectCount = true;
+    }
+
     vk::DeviceCreateInfo deviceCreateInfo{
-        .pNext =
-            ENGINE_DEVICE_EXTENSIONS.get<vk::PhysicalDeviceVulkan11Features>(),
+        .pNext = &ENGINE_DEVICE_EXTENSIONS.get<vk::PhysicalDeviceFeatures2>(),
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfo.size()),
         .pQueueCreateInfos = queueCreateInfo.data(),
         .enabledExtensionCount =
@@ -294,61 +305,15 @@ namespace keptech::vkh::setup {
   }
 
   std::expected<Renderer::CameraObjects, std::string>
-  createCameraObjects(const vk::raii::Device& device,
-                      vma::Allocator& allocator) {
-    vk::DescriptorPoolSize poolSize{
-        .type = vk::DescriptorType::eUniformBuffer,
-        .descriptorCount = 1,
-    };
-    VK_MAKE(descPool,
-            device.createDescriptorPool(
-                {.maxSets = 1, .poolSizeCount = 1, .pPoolSizes = &poolSize}),
-            "Faild to create camera "
-            "descriptor pool.");
-
+  createCameraObjects(const vk::raii::Device& device) {
     DescriptorLayoutBuilder layoutBuilder;
-    layoutBuilder.addBinding(0, vk::DescriptorType::eUniformBuffer,
+    layoutBuilder.addBinding(0, vk::DescriptorType::eUniformBufferDynamic,
                              vk::ShaderStageFlagBits::eAll);
     VKH_MAKE(descLayout, layoutBuilder.build(device, nullptr),
              "Failed to create camera descriptor layout.");
 
-    VK_MAKE(descSet,
-            device.allocateDescriptorSets({.descriptorPool = *descPool,
-                                           .descriptorSetCount = 1,
-                                           .pSetLayouts = &*descLayout}),
-            "Failed to allocate camera descriptor set.");
-
-    VKH_MAKE(uniformBuffer,
-             AllocatedBuffer::create(
-                 allocator,
-                 {
-                     .size = sizeof(core::cameras::Uniforms),
-                     .usage = vk::BufferUsageFlagBits::eUniformBuffer,
-                     .sharingMode = vk::SharingMode::eExclusive,
-                 },
-                 {
-                     .flags = vma::AllocationCreateFlagBits::eMapped,
-                     .usage = vma::MemoryUsage::eCpuToGpu,
-                 }),
-             "Failed to create camera uniform buffer.");
-
-    DescriptorWriter descWriter{};
-
-    descWriter.writeBuffer(0,
-                           vk::DescriptorBufferInfo{
-                               .buffer = uniformBuffer.buffer,
-                               .offset = 0,
-                               .range = sizeof(core::cameras::Uniforms),
-                           },
-                           DescriptorWriter::BufferType::Uniform);
-
-    descWriter.update(device, *descSet.front());
-
     Renderer::CameraObjects cameraObjects{
         .layout = std::move(descLayout),
-        .pool = std::move(descPool),
-        .descriptorSet = std::move(descSet.front()),
-        .uniformBuffer = uniformBuffer,
     };
 
     return std::move(cameraObjects);
@@ -395,7 +360,9 @@ namespace keptech::vkh {
         queueIndices.graphics, queueIndices.present, queueIndices.compute,
         queueIndices.transfer};
 
-    VKH_MAKE(device, createDevice(physDevice, uniqueQueueFamilies),
+    VKH_MAKE(device,
+             createDevice(physDevice, uniqueQueueFamilies,
+                          createInfo.gpuDriven),
              "Failed to create logical device.");
 
     VKH_MAKE(queues, getQueues(device, queueIndices, uniqueQueueFamilies),
@@ -449,6 +416,15 @@ namespace keptech::vkh {
       }
     }
 
+    // Every thread that may run a recording job gets its own pool per frame.
+    size_t recordingThreads = ecs::ECS::get().getThreadPool().getConcurrency();
+    for (auto* pools : poolsArray) {
+      auto reserved = pools->reserveRecording(device, recordingThreads);
+      if (!reserved) {
+        return std::unexpected(reserved.error());
+      }
+    }
+
     VK_MAKE(transferPool,
             device.createCommandPool(vk::CommandPoolCreateInfo{
                 .flags = vk::CommandPoolCreateFlagBits::eTransient,
@@ -495,10 +471,22 @@ namespace keptech::vkh {
         .transferPool = std::move(transferPoolStruct),
     };
 
-    VKH_MAKE(cameraObjects,
-             createCameraObjects(vkcore.device.logical, allocator),
+    VKH_MAKE(pipelineCache,
+             PipelineCache::create(vkcore.device.logical,
+                                   vkcore.device.physical,
+                                   createInfo.pipelineCachePath),
+             "Failed to create pipeline cache.");
+
+    VKH_MAKE(cameraObjects, createCameraObjects(vkcore.device.logical),
              "Failed to create camera objects.");
 
+    VKH_MAKE(frameAllocator,
+             FrameAllocator::create(
+                 vkcore.device.logical, allocator,
+                 vkcore.device.physical.getProperties().limits,
+                 cameraObjects.layout, sizeof(core::cameras::Uniforms)),
+             "Failed to create frame allocator.");
+
     VKH_MAKE(imguiObjects,
              keptech::vkh::setup::setupImGui(
                  window, vkcore.instance, vkcore.device.logical,
@@ -506,10 +494,27 @@ namespace keptech::vkh {
                  vkcore.swapchain.config().format.format),
              "Failed to create ImGui Vulkan objects.");
 
+    std::optional<GpuCulling> gpuCulling = std::nullopt;
+    if (createInfo.gpuDriven) {
+      VKH_MAKE(culling,
+               GpuCulling::create(vkcore.device.logical, allocator,
+                                  pipelineCache,
+                                  vkcore.queues.graphics.index,
+                                  vkcore.queues.compute.index),
+               "Failed to create GPU culling.");
+      gpuCulling = std::move(culling);
+    }
+
     VK_DEBUG("Vulkan renderer created successfully.");
 
-    Renderer r{window, std::move(vkcore), allocator, std::move(imguiObjects),
-               std::move(cameraObjects)};
+    Renderer r{window,
+               std::move(vkcore),
+               allocator,
+               std::move(imguiObjects),
+               std::move(cameraObjects),
+               std::move(frameAllocator),
+               std::move(pipelineCache),
+               std::move(gpuCulling)};
 
     auto& renderer = addToEcs(std::move(r));
     return &renderer;
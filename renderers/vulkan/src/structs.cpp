@@ -3,6 +3,36 @@
 #include "macros.hpp"
 
 namespace keptech::vkh {
+  std::expected<std::reference_wrapper<const vk::raii::CommandBuffer>,
+                std::string>
+  CommandPool::acquire(const vk::raii::Device& device,
+                       vk::CommandBufferLevel level) {
+    bool primary = level == vk::CommandBufferLevel::ePrimary;
+    auto& buffers = primary ? primaries : secondaries;
+    size_t& used = primary ? usedPrimaries : usedSecondaries;
+
+    if (used == buffers.size()) {
+      VK_MAKE(allocated,
+              device.allocateCommandBuffers({
+                  .commandPool = *pool,
+                  .level = level,
+                  .commandBufferCount = 1,
+              }),
+              "Failed to allocate command buffer");
+      ++allocations;
+      buffers.push_back(std::move(allocated.front()));
+    }
+
+    return std::cref(buffers[used++]);
+  }
+
+  void CommandPool::reset() {
+    pool.reset();
+    usedPrimaries = 0;
+    usedSecondaries = 0;
+    allocations = 0;
+  }
+
   std::expected<AllocatedBuffer, std::string>
   AllocatedBuffer::create(vma::Allocator& allocator,
                           const vk::BufferCreateInfo& bufInfo,